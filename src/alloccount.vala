@@ -0,0 +1,148 @@
+/*
+ * Copyright 2026 The Gt authors
+ *
+ * This file is part of Gt.
+ *
+ * Gt is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * Gt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Gt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gt {
+// Must match GtAllocShimCounters in allocshim.c
+private struct AllocShimCounters {
+    public int active;
+    public uint64 n_allocations;
+    public uint64 n_frees;
+    public int64 bytes;
+    public int64 peak_bytes;
+}
+
+[CCode (has_target = false)]
+private delegate AllocShimCounters *AllocShimGetCounters();
+
+/**
+ * Allocations made while running a block of code, as counted by
+ * gt_count_allocations().
+ */
+public struct AllocStats {
+    /** Number of blocks of memory allocated */
+    public uint64 n_allocations;
+    /** Number of blocks of memory freed */
+    public uint64 n_frees;
+    /** Bytes allocated minus bytes freed */
+    public int64 net_bytes;
+    /** Largest value that net_bytes reached while the block was running */
+    public int64 peak_bytes;
+}
+
+// Finds the allocation counting shim, if it was loaded with LD_PRELOAD
+private AllocShimGetCounters? find_alloc_shim() {
+    var program = Module.open(null, ModuleFlags.LAZY);
+    void *symbol;
+    if (program == null || !program.symbol("gt_alloc_shim_get_counters", out symbol))
+        return null;
+    return (AllocShimGetCounters) symbol;
+}
+
+/**
+ * Whether allocations can be counted.
+ *
+ * Allocations can only be counted if the Gt allocation counting shim,
+ * `libgt-allocshim.so`, was loaded into the test program with `LD_PRELOAD`.
+ * Gt's own tests are run this way.
+ *
+ * @return true if gt_count_allocations() will work.
+ */
+public bool allocation_counting_available() {
+    return find_alloc_shim() != null;
+}
+
+/**
+ * Counts the memory allocations that a block of code makes.
+ *
+ * Only allocations made through malloc() and friends, in the calling thread,
+ * are counted.
+ * This requires the allocation counting shim; see
+ * gt_allocation_counting_available().
+ *
+ * @param block Code to run
+ * @param stats Return location for the allocation counts
+ * @return false if allocations can't be counted, in which case @block is not
+ * run.
+ */
+public bool count_allocations(Block block, out AllocStats stats) {
+    stats = AllocStats();
+    var get_counters = find_alloc_shim();
+    if (get_counters == null)
+        return false;
+    var counters = get_counters();
+    *counters = AllocShimCounters() { active = 1 };
+    block();
+    counters->active = 0;
+    stats.n_allocations = counters->n_allocations;
+    stats.n_frees = counters->n_frees;
+    stats.net_bytes = counters->bytes;
+    stats.peak_bytes = counters->peak_bytes;
+    return true;
+}
+
+/**
+ * Fails the current test if a block of code makes more than a number of
+ * memory allocations.
+ *
+ * The block is run @n_warmup times first, without counting, so that caches and
+ * other one-time allocations are out of the way, and the steady state is
+ * what is checked.
+ * If allocations can't be counted, the test is skipped with g_test_skip().
+ *
+ * @param max_allocations Maximum number of allocations
+ * @param n_warmup Number of times to run the block before counting
+ * @param block Code to run
+ * @return true if the block made no more than @max_allocations allocations,
+ * or if allocations couldn't be counted.
+ */
+public bool assert_allocations_at_most(uint64 max_allocations, uint n_warmup,
+    Block block)
+{
+    if (!allocation_counting_available()) {
+        Test.skip("Allocation counting shim is not loaded");
+        return true;
+    }
+    for (uint count = 0; count < n_warmup; count++)
+        block();
+    AllocStats stats;
+    count_allocations(block, out stats);
+    if (stats.n_allocations <= max_allocations)
+        return true;
+    Test.message("Block made %" + uint64.FORMAT + " allocations, more than " +
+        "the maximum of %" + uint64.FORMAT + " (%" + uint64.FORMAT +
+        " frees, peak %" + int64.FORMAT + " bytes)", stats.n_allocations,
+        max_allocations, stats.n_frees, stats.peak_bytes);
+    Test.fail();
+    return false;
+}
+
+/**
+ * Fails the current test if a block of code makes any memory allocations in
+ * the steady state.
+ *
+ * This is gt_assert_allocations_at_most() with a maximum of zero.
+ *
+ * @param n_warmup Number of times to run the block before counting
+ * @param block Code to run
+ * @return true if the block made no allocations, or if allocations couldn't
+ * be counted.
+ */
+public bool assert_no_allocations(uint n_warmup, Block block) {
+    return assert_allocations_at_most(0, n_warmup, block);
+}
+}  // namespace Gt
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2026 The Gt authors
+ *
+ * This file is part of Gt.
+ *
+ * Gt is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * Gt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Gt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Allocation counting shim, loaded into test programs with LD_PRELOAD.
+
+It wraps the glibc allocator and counts allocations made by each thread while
+that thread has counting switched on. Gt finds gt_alloc_shim_get_counters()
+at runtime with g_module_symbol(), so test programs work the same whether or
+not the shim is loaded; without it, allocations just can't be counted.
+
+This file must not call anything that might allocate, and it doesn't use
+GLib, because GLib's allocations are among the ones being counted. */
+
+#include <errno.h>
+#include <malloc.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Must match AllocShimCounters in alloccount.vala */
+typedef struct
+{
+  int active;
+  uint64_t n_allocations;
+  uint64_t n_frees;
+  int64_t bytes;       /* allocated minus freed since counting started */
+  int64_t peak_bytes;
+} GtAllocShimCounters;
+
+/* Initial-exec TLS is set up when the shim is loaded, so accessing it never
+calls malloc() */
+static __thread GtAllocShimCounters counters
+  __attribute__ ((tls_model ("initial-exec")));
+
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t n_members, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+extern void *__libc_memalign (size_t alignment, size_t size);
+extern void __libc_free (void *ptr);
+
+__attribute__ ((visibility ("default")))
+GtAllocShimCounters *
+gt_alloc_shim_get_counters (void)
+{
+  return &counters;
+}
+
+static void
+count_allocation (void *ptr)
+{
+  if (!counters.active || ptr == NULL)
+    return;
+  counters.n_allocations++;
+  counters.bytes += malloc_usable_size (ptr);
+  if (counters.bytes > counters.peak_bytes)
+    counters.peak_bytes = counters.bytes;
+}
+
+static void
+count_free (void *ptr)
+{
+  if (!counters.active || ptr == NULL)
+    return;
+  counters.n_frees++;
+  counters.bytes -= malloc_usable_size (ptr);
+}
+
+__attribute__ ((visibility ("default")))
+void *
+malloc (size_t size)
+{
+  void *retval = __libc_malloc (size);
+  count_allocation (retval);
+  return retval;
+}
+
+__attribute__ ((visibility ("default")))
+void *
+calloc (size_t n_members,
+        size_t size)
+{
+  void *retval = __libc_calloc (n_members, size);
+  count_allocation (retval);
+  return retval;
+}
+
+/* A realloc() counts as freeing the old block and allocating a new one */
+__attribute__ ((visibility ("default")))
+void *
+realloc (void *ptr,
+         size_t size)
+{
+  size_t old_size = ptr != NULL ? malloc_usable_size (ptr) : 0;
+  void *retval = __libc_realloc (ptr, size);
+  if (retval == NULL && size != 0)
+    return NULL;  /* the old block is untouched */
+  if (counters.active && ptr != NULL)
+    {
+      counters.n_frees++;
+      counters.bytes -= old_size;
+    }
+  count_allocation (retval);
+  return retval;
+}
+
+__attribute__ ((visibility ("default")))
+void
+free (void *ptr)
+{
+  count_free (ptr);
+  __libc_free (ptr);
+}
+
+__attribute__ ((visibility ("default")))
+void *
+memalign (size_t alignment,
+          size_t size)
+{
+  void *retval = __libc_memalign (alignment, size);
+  count_allocation (retval);
+  return retval;
+}
+
+__attribute__ ((visibility ("default")))
+void *
+aligned_alloc (size_t alignment,
+               size_t size)
+{
+  return memalign (alignment, size);
+}
+
+__attribute__ ((visibility ("default")))
+int
+posix_memalign (void  **ptr,
+                size_t  alignment,
+                size_t  size)
+{
+  if (alignment % sizeof (void *) != 0 ||
+      (alignment & (alignment - 1)) != 0)
+    return EINVAL;
+  void *retval = memalign (alignment, size);
+  if (retval == NULL)
+    return ENOMEM;
+  *ptr = retval;
+  return 0;
+}
@@ -0,0 +1,291 @@
+/*
+ * Copyright 2026 The Gt authors
+ *
+ * This file is part of Gt.
+ *
+ * Gt is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * Gt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Gt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gt {
+/**
+ * How gt_bench_run() reports its results.
+ */
+public enum BenchOutput {
+    /** One line of summary, printed with g_test_message() */
+    SUMMARY,
+    /**
+     * A YAML document with all the statistics, printed with g_test_message()
+     * so that it passes through the TAP driver as a block of comments
+     */
+    YAML,
+    /** Nothing; only the returned #GtBenchResult */
+    NONE
+}
+
+/**
+ * Options for gt_bench_run().
+ */
+public class BenchOptions : Object {
+    /**
+     * How long to run the block before measuring, in microseconds.
+     */
+    public int64 warmup_time { get; set; default = 50000; }
+
+    /**
+     * Minimum duration of one sample, in microseconds.
+     * The block is run as many times as needed in each sample to take at
+     * least this long, so that the resolution of the clock doesn't matter.
+     */
+    public int64 sample_time { get; set; default = 1000; }
+
+    /**
+     * How long to keep taking samples, in microseconds.
+     */
+    public int64 measure_time { get; set; default = 500000; }
+
+    /**
+     * Minimum number of samples to take, even if that takes longer than
+     * #GtBenchOptions:measure-time.
+     */
+    public uint min_samples { get; set; default = 10; }
+
+    /**
+     * Maximum number of samples to take.
+     * Must be at least 1, and at least #GtBenchOptions:min-samples.
+     */
+    public uint max_samples { get; set; default = 1000; }
+
+    /**
+     * How to report the results.
+     */
+    public BenchOutput output { get; set; default = BenchOutput.SUMMARY; }
+
+    /**
+     * Key file with the results of earlier runs, or null to not compare
+     * against a baseline.
+     * Each benchmark is a group, named after the benchmark, with the median
+     * time per iteration in nanoseconds as the `median` key.
+     */
+    public string? baseline_file { get; set; default = null; }
+
+    /**
+     * How much slower than the baseline the median may be before the test
+     * fails, as a fraction of the baseline.
+     */
+    public double threshold { get; set; default = 0.1; }
+
+    /**
+     * Whether to store the result in #GtBenchOptions:baseline-file, instead
+     * of comparing against it.
+     */
+    public bool update_baseline { get; set; default = false; }
+}
+
+/**
+ * Results of gt_bench_run().
+ * All times are in nanoseconds per iteration of the block.
+ */
+public class BenchResult : Object {
+    /** Name of the benchmark */
+    public string name { get; private set; }
+    /** Number of samples taken */
+    public uint n_samples { get; private set; }
+    /** Number of times the block was run in each sample */
+    public uint64 iterations_per_sample { get; private set; }
+    /** Median time */
+    public double median { get; private set; }
+    /** Median absolute deviation from the median */
+    public double mad { get; private set; }
+    /** Fastest sample */
+    public double min { get; private set; }
+    /** Slowest sample */
+    public double max { get; private set; }
+    /** 90th percentile */
+    public double p90 { get; private set; }
+    /** 99th percentile */
+    public double p99 { get; private set; }
+
+    internal BenchResult(string name, double[] samples,
+        uint64 iterations_per_sample)
+    {
+        this.name = name;
+        this.iterations_per_sample = iterations_per_sample;
+        n_samples = samples.length;
+        Posix.qsort(samples, samples.length, sizeof(double), compare_doubles);
+        median = percentile(samples, 0.5);
+        min = samples[0];
+        max = samples[samples.length - 1];
+        p90 = percentile(samples, 0.9);
+        p99 = percentile(samples, 0.99);
+
+        var deviations = new double[samples.length];
+        for (var ix = 0; ix < samples.length; ix++) {
+            var deviation = samples[ix] - median;
+            deviations[ix] = deviation < 0 ? -deviation : deviation;
+        }
+        Posix.qsort(deviations, deviations.length, sizeof(double), compare_doubles);
+        mad = percentile(deviations, 0.5);
+    }
+
+    private static int compare_doubles(void *a, void *b) {
+        var x = *(double *) a;
+        var y = *(double *) b;
+        return x < y ? -1 : (x > y ? 1 : 0);
+    }
+
+    // Linear interpolation between the closest ranks of @sorted
+    private static double percentile(double[] sorted, double fraction) {
+        var position = fraction * (sorted.length - 1);
+        var below = (int) position;
+        var above = int.min(below + 1, sorted.length - 1);
+        return sorted[below] + (sorted[above] - sorted[below]) * (position - below);
+    }
+
+    internal void print(BenchOutput output) {
+        switch (output) {
+        case BenchOutput.SUMMARY:
+            Test.message("bench %s: median %.1f ns (MAD %.1f), p90 %.1f ns, " +
+                "p99 %.1f ns, %u samples of %" + uint64.FORMAT + " iterations",
+                name, median, mad, p90, p99, n_samples, iterations_per_sample);
+            break;
+        case BenchOutput.YAML:
+            Test.message("---");
+            Test.message("bench: %s", name);
+            Test.message("unit: ns");
+            foreach (var stat in new string[] {
+                "median", "mad", "min", "max", "p90", "p99"
+            }) {
+                var value = Value(typeof(double));
+                get_property(stat, ref value);
+                Test.message("%s: %.1f", stat, value.get_double());
+            }
+            Test.message("samples: %u", n_samples);
+            Test.message("iterations_per_sample: %" + uint64.FORMAT,
+                iterations_per_sample);
+            Test.message("...");
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// Runs @block @iterations times and returns how long that took, in
+// microseconds of monotonic time
+private int64 time_block(Block block, uint64 iterations) {
+    var start = get_monotonic_time();
+    for (uint64 count = 0; count < iterations; count++)
+        block();
+    return get_monotonic_time() - start;
+}
+
+// Limit on the number of times the block is run in one sample
+private const uint64 MAX_ITERATIONS = 1 << 30;
+
+/**
+ * Measures how long a block of code takes to run.
+ *
+ * The block is first run for a while without measuring, to warm up caches.
+ * Then the number of times to run it in each sample is found, so that each
+ * sample takes at least #GtBenchOptions:sample-time, up to a limit of 2^30
+ * times for blocks that take next to no time at all.
+ * Then samples are taken until #GtBenchOptions:measure-time is up.
+ * The results are reported according to #GtBenchOptions:output.
+ *
+ * If #GtBenchOptions:baseline-file is set, the median time is compared with
+ * the one stored there for the same @name, and the test fails with
+ * g_test_fail() if it is more than #GtBenchOptions:threshold slower.
+ *
+ * Benchmarks are only meaningful in optimized builds on a quiet machine, so
+ * you may want to run them only with `-m perf`; see g_test_perf().
+ *
+ * @param name Name of the benchmark, used in the report and the baseline file
+ * @param block Code to measure
+ * @param options Options, or null to use the defaults
+ * @return the results
+ */
+public BenchResult bench_run(string name, Block block, BenchOptions? options = null)
+    requires(options == null ||
+        (options.max_samples > 0 && options.min_samples <= options.max_samples))
+{
+    var opts = options ?? new BenchOptions();
+
+    var warmup_end = get_monotonic_time() + opts.warmup_time;
+    do {
+        block();
+    } while (get_monotonic_time() < warmup_end);
+
+    uint64 iterations = 1;
+    while (iterations < MAX_ITERATIONS &&
+        time_block(block, iterations) < opts.sample_time)
+        iterations *= 2;
+
+    var samples = new double[opts.max_samples];
+    uint n_samples = 0;
+    // Always take at least one sample, so that there is a result
+    var min_samples = uint.max(opts.min_samples, 1);
+    var measure_end = get_monotonic_time() + opts.measure_time;
+    while (n_samples < opts.max_samples &&
+        (n_samples < min_samples || get_monotonic_time() < measure_end)) {
+        var elapsed = time_block(block, iterations);
+        samples[n_samples++] = elapsed * 1000.0 / iterations;
+    }
+
+    var result = new BenchResult(name, samples[0:n_samples], iterations);
+    result.print(opts.output);
+    if (opts.baseline_file != null)
+        compare_with_baseline(result, opts);
+    return result;
+}
+
+private void compare_with_baseline(BenchResult result, BenchOptions options) {
+    var baseline = new KeyFile();
+    try {
+        baseline.load_from_file(options.baseline_file, KeyFileFlags.KEEP_COMMENTS);
+    } catch (FileError.NOENT e) {
+        // Start a new baseline file
+    } catch (Error e) {
+        Test.message("Could not read benchmark baseline %s: %s",
+            options.baseline_file, e.message);
+        Test.fail();
+        return;
+    }
+
+    if (options.update_baseline) {
+        baseline.set_double(result.name, "median", result.median);
+        try {
+            baseline.save_to_file(options.baseline_file);
+        } catch (FileError e) {
+            Test.message("Could not write benchmark baseline %s: %s",
+                options.baseline_file, e.message);
+            Test.fail();
+        }
+        return;
+    }
+
+    double expected;
+    try {
+        expected = baseline.get_double(result.name, "median");
+    } catch (KeyFileError e) {
+        Test.message("No baseline for bench %s in %s", result.name,
+            options.baseline_file);
+        return;
+    }
+    if (result.median > expected * (1 + options.threshold)) {
+        Test.message("bench %s regressed: median %.1f ns, baseline %.1f ns " +
+            "(threshold %.0f%%)", result.name, result.median, expected,
+            options.threshold * 100);
+        Test.fail();
+    }
+}
+}  // namespace Gt
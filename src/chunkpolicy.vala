@@ -0,0 +1,112 @@
+/*
+ * Copyright 2026 The Gt authors
+ *
+ * This file is part of Gt.
+ *
+ * Gt is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * Gt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Gt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gt {
+/**
+ * Limit on the number of bytes transferred by each read or write
+ *
+ * Real streams are allowed to read or write fewer bytes than were asked for,
+ * but in-memory streams never do, so code that mishandles short transfers
+ * passes its tests.
+ * Set a chunk policy on a #GtMockFile with
+ * gt_mock_file_set_read_chunk_policy() or gt_mock_file_set_write_chunk_policy()
+ * and each read or write on the streams subsequently opened on that file will
+ * transfer at most as many bytes as the policy allows.
+ *
+ * Each stream starts at the beginning of the policy's sequence of sizes, so
+ * two streams opened on the same file see the same sequence.
+ */
+public class ChunkPolicy : Object {
+    private size_t[] sizes;
+    private bool random;
+    private uint32 seed;
+
+    /**
+     * Creates a policy that limits every transfer to @size bytes.
+     * Pass 1 to get one-byte reads or writes.
+     *
+     * @param size Maximum number of bytes per call
+     * @return the new #GtChunkPolicy
+     */
+    public ChunkPolicy.fixed(size_t size) {
+        sizes = { size };
+    }
+
+    /**
+     * Creates a policy that limits successive transfers to successive elements
+     * of @sizes, starting over from the first element after the last.
+     *
+     * @param sizes Maximum number of bytes for each call
+     * @return the new #GtChunkPolicy
+     */
+    public ChunkPolicy.sequence(size_t[] sizes) {
+        this.sizes = sizes;
+    }
+
+    /**
+     * Creates a policy that limits each transfer to a random number of bytes
+     * between @min_size and @max_size, inclusive.
+     * The sizes are drawn from a #GRand seeded with @seed, so they are the same
+     * every time.
+     *
+     * @param seed Seed for the random number generator
+     * @param min_size Minimum of the maximum number of bytes per call
+     * @param max_size Maximum number of bytes per call
+     * @return the new #GtChunkPolicy
+     */
+    public ChunkPolicy.random(uint32 seed, size_t min_size, size_t max_size) {
+        sizes = { min_size, size_t.max(min_size, max_size) };
+        random = true;
+        this.seed = seed;
+    }
+
+    internal Rand? create_rand() {
+        return random ? new Rand.with_seed(seed) : null;
+    }
+
+    // Returns the maximum number of bytes for call number @index on a stream.
+    // Never returns 0, since that would signal end-of-file to a reader.
+    internal size_t get_chunk_size(uint index, Rand? rand) {
+        if (sizes.length == 0)
+            return size_t.MAX;
+        size_t retval;
+        if (rand != null)
+            retval = (size_t) rand.double_range(sizes[0], sizes[1] + 1.0);
+        else
+            retval = sizes[index % sizes.length];
+        return size_t.max(retval, 1);
+    }
+}
+
+// Per-stream position in a ChunkPolicy's sequence of sizes
+internal class ChunkCursor {
+    private ChunkPolicy policy;
+    private Rand? rand;
+    private uint index = 0;
+
+    public ChunkCursor(ChunkPolicy policy) {
+        this.policy = policy;
+        rand = policy.create_rand();
+    }
+
+    public int limit(int requested) {
+        var chunk = policy.get_chunk_size(index++, rand);
+        return chunk < requested ? (int) chunk : requested;
+    }
+}
+}  // namespace Gt
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2026 The Gt authors
+ *
+ * This file is part of Gt.
+ *
+ * Gt is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * Gt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Gt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gt {
+// memmem() is a GNU extension; it is compiled with _GNU_SOURCE defined.
+[CCode (cname = "memmem", cheader_filename = "string.h")]
+private extern void *memmem(void *haystack, size_t haystack_len, void *needle,
+    size_t needle_len);
+
+// Helpers for the content assertions on MockFile. They work on the contents in
+// place and on fixed-size chunks of the other side, so that comparing large
+// files never needs a second full copy. The comparisons themselves are done by
+// the C library's memcmp() and memmem(), which are vectorized.
+namespace ContentCheck {
+    internal const size_t CHUNK_SIZE = 64 * 1024;
+    // Number of bytes shown on either side of a mismatch
+    private const size_t CONTEXT_SIZE = 16;
+
+    // Returns the offset of the first byte that differs between @a and @b,
+    // both @len bytes long, or -1 if they are equal.
+    internal int64 find_mismatch(uint8 *a, uint8 *b, size_t len) {
+        for (size_t pos = 0; pos < len; pos += CHUNK_SIZE) {
+            var n = size_t.min(CHUNK_SIZE, len - pos);
+            if (Memory.cmp(a + pos, b + pos, n) == 0)
+                continue;
+            for (size_t ix = pos; ix < pos + n; ix++) {
+                if (a[ix] != b[ix])
+                    return (int64) ix;
+            }
+        }
+        return -1;
+    }
+
+    // Returns the offset of the first occurrence of @needle in @data at or
+    // after @start, or -1.
+    internal int64 find(uint8 *data, size_t len, uint8[] needle, size_t start) {
+        if (start > len)
+            return -1;
+        if (needle.length == 0)
+            return (int64) start;
+        uint8 *found = memmem(data + start, len - start, needle, needle.length);
+        return found == null ? -1 : (int64) (found - data);
+    }
+
+    // Renders the bytes around @offset with anything unprintable escaped, and
+    // the byte at @offset in brackets; empty brackets mean the end of the data.
+    internal string describe_window(uint8 *data, size_t len, size_t offset) {
+        var begin = offset > CONTEXT_SIZE ? offset - CONTEXT_SIZE : 0;
+        var end = size_t.min(len, offset + CONTEXT_SIZE);
+        var builder = new StringBuilder(begin > 0 ? "...\"" : "\"");
+        for (var ix = begin; ix < end; ix++) {
+            if (ix == offset)
+                builder.append_c('[');
+            var octet = data[ix];
+            if (octet == '"' || octet == '\\')
+                builder.append_printf("\\%c", octet);
+            else if (octet == '\n')
+                builder.append("\\n");
+            else if (octet >= 0x20 && octet < 0x7f)
+                builder.append_c((char) octet);
+            else
+                builder.append_printf("\\x%02x", octet);
+            if (ix == offset)
+                builder.append_c(']');
+        }
+        if (offset >= len)
+            builder.append("[]");
+        builder.append_c('"');
+        if (end < len)
+            builder.append("...");
+        return builder.str;
+    }
+
+    // Marks the current test as failed and explains why in the test log.
+    // @actual_window and @expected_window come from describe_window().
+    internal void report_mismatch(string what, uint64 offset,
+        string actual_window, string expected_window)
+    {
+        Test.message("%s: contents differ at offset %" + uint64.FORMAT +
+            "\n  actual:   %s\n  expected: %s", what, offset, actual_window,
+            expected_window);
+        Test.fail();
+    }
+}
+}  // namespace Gt
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2026 The Gt authors
+ *
+ * This file is part of Gt.
+ *
+ * Gt is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * Gt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Gt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gt {
+// Incremental 64-bit FNV-1a hash of a mock file's contents. It doesn't need to
+// be cryptographically strong, only cheap to extend as data is written, since
+// it is only used to compute etags.
+internal struct ContentHash {
+    private const uint64 OFFSET_BASIS = 0xcbf29ce484222325;
+    private const uint64 PRIME = 0x100000001b3;
+
+    public uint64 value;
+
+    public ContentHash() {
+        value = OFFSET_BASIS;
+    }
+
+    public void update(uint8[] data) {
+        var hash = value;
+        foreach (var octet in data) {
+            hash ^= octet;
+            hash *= PRIME;
+        }
+        value = hash;
+    }
+
+    public string to_etag() {
+        return value.to_string("%016" + uint64.FORMAT_MODIFIER + "x");
+    }
+
+    public static string compute_etag(Bytes contents) {
+        var hash = ContentHash();
+        hash.update(contents.get_data());
+        return hash.to_etag();
+    }
+}
+}  // namespace Gt
@@ -0,0 +1,285 @@
+/*
+ * Copyright 2026 The Gt authors
+ *
+ * This file is part of Gt.
+ *
+ * Gt is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * Gt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Gt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gt {
+/**
+ * Operations on mock files and their streams that a #GtFaultInjector can make
+ * fail.
+ */
+public enum MockOperation {
+    /** g_file_read() */
+    READ,
+    /** g_file_create() */
+    CREATE,
+    /** g_file_replace() */
+    REPLACE,
+    /** g_file_query_info() */
+    QUERY_INFO,
+    /** g_input_stream_read() on a stream obtained from a mock file */
+    STREAM_READ,
+    /** g_output_stream_write() on a stream obtained from a mock file */
+    STREAM_WRITE,
+    /** g_output_stream_close() on a stream obtained from a mock file */
+    STREAM_CLOSE
+}
+
+/**
+ * Faults that a #GtFaultInjector can inject.
+ */
+public enum MockFault {
+    /** No fault; the operation proceeds normally */
+    NONE,
+    /** Fail with %G_IO_ERROR_NO_SPACE */
+    NO_SPACE,
+    /** Fail with %G_IO_ERROR_PERMISSION_DENIED */
+    PERMISSION_DENIED,
+    /** Fail with %G_IO_ERROR_BUSY */
+    BUSY,
+    /** Fail with %G_IO_ERROR_CANCELLED */
+    CANCELLED,
+    /**
+     * Transfer only part of the requested bytes; this only has an effect on
+     * %GT_MOCK_OPERATION_STREAM_READ and %GT_MOCK_OPERATION_STREAM_WRITE
+     */
+    SHORT_IO
+}
+
+private class FaultRule {
+    public MockOperation operation;
+    public PatternSpec? pattern;
+    public uint nth_call;  // 0 means every matching call
+    public double probability;  // negative means not random
+    public MockFault fault;
+    public uint calls = 0;
+
+    public bool matches(MockOperation operation, string path) {
+        return operation == this.operation &&
+            (pattern == null || pattern.match_string(path));
+    }
+}
+
+private class FaultRecord {
+    public uint64 call;
+    public MockOperation operation;
+    public string path;
+    public MockFault fault;
+}
+
+/**
+ * Scriptable source of errors for mock files
+ *
+ * Assign a fault injector to a #GtMockFile with gt_mock_file_set_fault_injector()
+ * and it will make operations on that file, its descendants, and the streams
+ * opened on them fail according to the rules you add.
+ * Rules select operations by type and by a glob-style pattern (see
+ * #GPatternSpec) matched against the file's path within its mock tree, such
+ * as `/data/*.log`.
+ * A rule either fires on one particular matching call, on every matching
+ * call, or randomly with a given probability.
+ * Random rules draw from a #GRand seeded with #GtFaultInjector:seed, so a
+ * failing run can be reproduced exactly by reusing its seed.
+ *
+ * Every fault that was applied is recorded, so that tests can read back the
+ * schedule with gt_fault_injector_get_schedule() and make assertions about
+ * how the code under test retried.
+ */
+public class FaultInjector : Object {
+    private Mutex mutex = Mutex();
+    private Rand rand;
+    private List<FaultRule> rules;
+    private GenericArray<FaultRecord> schedule = new GenericArray<FaultRecord>();
+    private uint64 _n_calls = 0;
+
+    /**
+     * Seed for the random number generator used by rules added with
+     * gt_fault_injector_add_random_fault().
+     */
+    public uint32 seed { get; construct; }
+
+    /**
+     * Number of operations that have consulted this fault injector, whether or
+     * not a fault was injected.
+     */
+    public uint64 n_calls { get { return _n_calls; } }
+
+    /**
+     * Number of faults that have been injected.
+     */
+    public uint n_faults { get { return schedule.length; } }
+
+    /**
+     * Creates a new fault injector with no rules.
+     *
+     * @param seed Seed for random fault rules
+     * @return the new #GtFaultInjector
+     */
+    public FaultInjector(uint32 seed = 0) {
+        Object(seed: seed);
+    }
+
+    construct {
+        rand = new Rand.with_seed(seed);
+    }
+
+    /**
+     * Adds a rule that injects @fault into a particular call.
+     *
+     * @param operation The type of operation to make fail
+     * @param path_pattern A glob-style pattern matched against the path of
+     * the mock file, or null to match any file
+     * @param nth_call Inject the fault on the nth call (counting from 1) that
+     * matches @operation and @path_pattern, or 0 to inject it on every
+     * matching call
+     * @param fault The fault to inject
+     */
+    public void add_fault(MockOperation operation, string? path_pattern,
+        uint nth_call, MockFault fault)
+    {
+        add_rule(operation, path_pattern, nth_call, -1.0, fault);
+    }
+
+    /**
+     * Adds a rule that injects @fault randomly into matching calls.
+     *
+     * @param operation The type of operation to make fail
+     * @param path_pattern A glob-style pattern matched against the path of
+     * the mock file, or null to match any file
+     * @param probability The chance, between 0 and 1, that any matching call
+     * will fail
+     * @param fault The fault to inject
+     */
+    public void add_random_fault(MockOperation operation, string? path_pattern,
+        double probability, MockFault fault)
+    {
+        add_rule(operation, path_pattern, 0, probability.clamp(0.0, 1.0), fault);
+    }
+
+    private void add_rule(MockOperation operation, string? path_pattern,
+        uint nth_call, double probability, MockFault fault)
+    {
+        var rule = new FaultRule();
+        rule.operation = operation;
+        if (path_pattern != null)
+            rule.pattern = new PatternSpec(path_pattern);
+        rule.nth_call = nth_call;
+        rule.probability = probability;
+        rule.fault = fault;
+
+        mutex.lock();
+        rules.append(rule);
+        mutex.unlock();
+    }
+
+    /**
+     * Removes all rules.
+     * The recorded schedule is left intact.
+     */
+    public void clear_faults() {
+        mutex.lock();
+        rules = new List<FaultRule>();
+        mutex.unlock();
+    }
+
+    /**
+     * Forgets the recorded schedule and the call counts of all rules, and
+     * reseeds the random number generator with #GtFaultInjector:seed, so that
+     * the same sequence of calls will produce the same faults again.
+     */
+    public void reset() {
+        mutex.lock();
+        foreach (var rule in rules)
+            rule.calls = 0;
+        schedule = new GenericArray<FaultRecord>();
+        rand.set_seed(seed);
+        _n_calls = 0;
+        mutex.unlock();
+    }
+
+    /**
+     * Returns the faults that have been injected so far, in order.
+     *
+     * The return value is an array of tuples of type `(tsss)`, consisting of
+     * the number of the call (counting from 1 among all calls that consulted
+     * this fault injector), the nickname of the #GtMockOperation, the path of
+     * the mock file, and the nickname of the #GtMockFault.
+     *
+     * @return a #GVariant of type `a(tsss)`
+     */
+    public Variant get_schedule() {
+        var builder = new VariantBuilder(new VariantType("a(tsss)"));
+        mutex.lock();
+        schedule.foreach((record) => {
+            builder.add("(tsss)", record.call,
+                get_nick(typeof(MockOperation), record.operation), record.path,
+                get_nick(typeof(MockFault), record.fault));
+        });
+        mutex.unlock();
+        return builder.end();
+    }
+
+    internal static unowned string get_nick(Type enum_type, int value) {
+        var klass = (EnumClass) enum_type.class_ref();
+        return klass.get_value(value).value_nick;
+    }
+
+    // Decides whether to inject a fault into @operation on the mock file at
+    // @path. Throws the injected error, if any; otherwise returns
+    // MockFault.SHORT_IO if the caller should transfer fewer bytes than
+    // requested, or MockFault.NONE.
+    internal MockFault check(MockOperation operation, string path) throws IOError {
+        var fault = MockFault.NONE;
+
+        mutex.lock();
+        _n_calls++;
+        foreach (var rule in rules) {
+            if (!rule.matches(operation, path))
+                continue;
+            rule.calls++;
+            bool fires;
+            if (rule.probability >= 0.0)
+                fires = rand.next_double() < rule.probability;
+            else
+                fires = rule.nth_call == 0 || rule.calls == rule.nth_call;
+            if (fires && fault == MockFault.NONE)
+                fault = rule.fault;
+        }
+        if (fault != MockFault.NONE) {
+            var record = new FaultRecord();
+            record.call = _n_calls;
+            record.operation = operation;
+            record.path = path;
+            record.fault = fault;
+            schedule.add(record);
+        }
+        mutex.unlock();
+
+        switch (fault) {
+        case MockFault.NO_SPACE:
+            throw new IOError.NO_SPACE("Injected fault: no space left.");
+        case MockFault.PERMISSION_DENIED:
+            throw new IOError.PERMISSION_DENIED("Injected fault: permission denied.");
+        case MockFault.BUSY:
+            throw new IOError.BUSY("Injected fault: busy.");
+        case MockFault.CANCELLED:
+            throw new IOError.CANCELLED("Injected fault: cancelled.");
+        default:
+            return fault;
+        }
+    }
+}
+}  // namespace Gt
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2026 The Gt authors
+ *
+ * This file is part of Gt.
+ *
+ * Gt is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * Gt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Gt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Records which thread is the main thread, so that the wait functions in
+wait.vala only ever run the global default main context from it. Vala has no
+way to run code when the library is loaded, so this is in C.
+
+Test programs link to libgt, so the library is loaded, and the constructor
+runs, on the main thread before main() starts. With compilers that don't
+support constructors, the first thread that asks is taken to be the main
+thread. */
+
+#include <glib.h>
+
+static GThread *main_thread = NULL;
+
+#ifdef __GNUC__
+__attribute__ ((constructor))
+static void
+record_main_thread (void)
+{
+  main_thread = g_thread_self ();
+}
+#endif
+
+gboolean
+_gt_is_main_thread (void)
+{
+  static gsize initialized = 0;
+  if (g_once_init_enter (&initialized))
+    {
+      if (main_thread == NULL)
+        main_thread = g_thread_self ();
+      g_once_init_leave (&initialized, 1);
+    }
+  return g_thread_self () == main_thread;
+}
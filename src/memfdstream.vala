@@ -0,0 +1,254 @@
+/*
+ * Copyright 2026 The Gt authors
+ *
+ * This file is part of Gt.
+ *
+ * Gt is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * Gt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Gt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gt {
+#if HAVE_MEMFD_CREATE
+// memfd_create() is Linux-specific; it is compiled with _GNU_SOURCE defined.
+[CCode (cname = "memfd_create", cheader_filename = "sys/mman.h")]
+private extern int memfd_create(string name, uint flags);
+[CCode (cname = "MFD_CLOEXEC", cheader_filename = "sys/mman.h")]
+private extern const uint MFD_CLOEXEC;
+#endif
+
+/**
+ * Where a #GtMockFile keeps its contents.
+ */
+public enum MockFileStorage {
+    /** In memory allocated on the heap; the default */
+    HEAP,
+    /**
+     * In an anonymous memory-backed file created with memfd_create(), so that
+     * streams on the mock file implement #GFileDescriptorBased and their file
+     * descriptors can be used with mmap(), sendfile(), and the like.
+     * Only available on Linux; elsewhere, opening a stream on the file fails
+     * with %G_IO_ERROR_NOT_SUPPORTED.
+     */
+    MEMFD
+}
+
+// Helpers for storing mock file contents in anonymous memory-backed files
+namespace Memfd {
+    internal IOError error_from_errno(string what) {
+        var errsv = Posix.errno;
+        return new IOError.FAILED("%s: %s", what, strerror(errsv));
+    }
+
+    internal int create(string name) throws IOError {
+#if HAVE_MEMFD_CREATE
+        var fd = memfd_create(name, MFD_CLOEXEC);
+        if (fd == -1)
+            throw error_from_errno("Could not create memfd for mock file");
+        return fd;
+#else
+        throw new IOError.NOT_SUPPORTED("Mock files can't be stored in a " +
+            "memfd on this system.");
+#endif
+    }
+
+    // Creates anonymous shared memory to be mapped by several processes. This
+    // is a memfd where available, and otherwise an unlinked temporary file.
+    internal int create_shared(string name) throws IOError {
+#if HAVE_MEMFD_CREATE
+        return create(name);
+#else
+        string path;
+        int fd;
+        try {
+            fd = FileUtils.open_tmp(name + "-XXXXXX", out path);
+        } catch (FileError e) {
+            throw new IOError.FAILED("Could not create shared memory: %s",
+                e.message);
+        }
+        FileUtils.unlink(path);
+        Posix.fcntl(fd, Posix.F_SETFD, Posix.FD_CLOEXEC);
+        return fd;
+#endif
+    }
+
+    // Opens another file description for the memfd, with its own offset, the
+    // way that opening the same file twice would. This goes through /proc, so
+    // it is Linux-only, like memfds themselves.
+    internal int reopen(int fd, int flags) throws IOError {
+        var path = "/proc/self/fd/%d".printf(fd);
+        var retval = Posix.open(path, flags | Posix.O_CLOEXEC);
+        if (retval == -1)
+            throw error_from_errno("Could not reopen memfd for mock file");
+        return retval;
+    }
+
+    internal void write_all(int fd, uint8[] data) throws IOError {
+        size_t pos = 0;
+        while (pos < data.length) {
+            var nwritten = Posix.write(fd, (uint8 *) data + pos, data.length - pos);
+            if (nwritten == -1) {
+                if (Posix.errno == Posix.EINTR)
+                    continue;
+                throw error_from_errno("Could not write to memfd");
+            }
+            pos += nwritten;
+        }
+    }
+
+    // Maps the memfd's contents. Mock files never write to a memfd again once
+    // it holds their contents, so the mapping can be used as immutable bytes.
+    internal Bytes map(int fd) throws IOError {
+        try {
+            return new MappedFile.from_fd(fd, false).get_bytes();
+        } catch (FileError e) {
+            throw new IOError.FAILED("Could not map memfd: %s", e.message);
+        }
+    }
+}
+
+// Seekable input stream reading from a memfd; like GUnixInputStream, but
+// seekable, since the memfd is a regular file
+internal class MemfdInputStream : InputStream, Seekable {
+    public int fd { get; private set; }
+
+    public MemfdInputStream(int fd) {
+        this.fd = fd;
+    }
+
+    public override ssize_t read([CCode(array_length_type = "gsize")] uint8[] buffer,
+        Cancellable? cancellable = null) throws IOError
+    {
+        ssize_t retval;
+        do {
+            if (cancellable != null)
+                cancellable.set_error_if_cancelled();
+            retval = Posix.read(fd, buffer, buffer.length);
+        } while (retval == -1 && Posix.errno == Posix.EINTR);
+        if (retval == -1)
+            throw Memfd.error_from_errno("Could not read from memfd");
+        return retval;
+    }
+
+    public override bool close(Cancellable? cancellable = null) throws IOError {
+        if (Posix.close(fd) == -1)
+            throw Memfd.error_from_errno("Could not close memfd");
+        return true;
+    }
+
+    public int64 tell() {
+        return Posix.lseek(fd, 0, Posix.SEEK_CUR);
+    }
+
+    public bool can_seek() {
+        return true;
+    }
+
+    public bool seek(int64 offset, SeekType type,
+        Cancellable? cancellable = null) throws Error
+    {
+        if (Posix.lseek(fd, (Posix.off_t) offset, seek_type_to_whence(type)) == -1)
+            throw Memfd.error_from_errno("Could not seek in memfd");
+        return true;
+    }
+
+    public bool can_truncate() {
+        return false;
+    }
+
+    public bool truncate(int64 offset, Cancellable? cancellable = null)
+        throws Error
+    {
+        throw new IOError.NOT_SUPPORTED("Can't truncate an input stream.");
+    }
+
+    internal static int seek_type_to_whence(SeekType type) {
+        switch (type) {
+        case SeekType.CUR:
+            return Posix.SEEK_CUR;
+        case SeekType.END:
+            return Posix.SEEK_END;
+        default:
+            return Posix.SEEK_SET;
+        }
+    }
+}
+
+// Seekable, truncatable output stream writing to a memfd. Closing it doesn't
+// close the memfd, because the mock file takes it over as its storage with
+// steal_fd(); if that doesn't happen, the memfd is closed when the stream is
+// finalized.
+internal class MemfdOutputStream : OutputStream, Seekable {
+    public int fd { get; private set; }
+
+    public MemfdOutputStream(int fd) {
+        this.fd = fd;
+    }
+
+    ~MemfdOutputStream() {
+        if (fd != -1)
+            Posix.close(fd);
+    }
+
+    public int steal_fd() {
+        var retval = fd;
+        fd = -1;
+        return retval;
+    }
+
+    public override ssize_t write([CCode(array_length_type = "gsize")] uint8[] buffer,
+        Cancellable? cancellable = null) throws IOError
+    {
+        ssize_t retval;
+        do {
+            if (cancellable != null)
+                cancellable.set_error_if_cancelled();
+            retval = Posix.write(fd, buffer, buffer.length);
+        } while (retval == -1 && Posix.errno == Posix.EINTR);
+        if (retval == -1)
+            throw Memfd.error_from_errno("Could not write to memfd");
+        return retval;
+    }
+
+    public override bool close(Cancellable? cancellable = null) throws IOError {
+        return true;
+    }
+
+    public int64 tell() {
+        return Posix.lseek(fd, 0, Posix.SEEK_CUR);
+    }
+
+    public bool can_seek() {
+        return true;
+    }
+
+    public bool seek(int64 offset, SeekType type,
+        Cancellable? cancellable = null) throws Error
+    {
+        var whence = MemfdInputStream.seek_type_to_whence(type);
+        if (Posix.lseek(fd, (Posix.off_t) offset, whence) == -1)
+            throw Memfd.error_from_errno("Could not seek in memfd");
+        return true;
+    }
+
+    public bool can_truncate() {
+        return true;
+    }
+
+    public bool truncate(int64 size, Cancellable? cancellable = null)
+        throws Error
+    {
+        if (Posix.ftruncate(fd, (Posix.off_t) size) == -1)
+            throw Memfd.error_from_errno("Could not truncate memfd");
+        return true;
+    }
+}
+}  // namespace Gt
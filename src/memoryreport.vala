@@ -0,0 +1,122 @@
+/*
+ * Copyright 2026 The Gt authors
+ *
+ * This file is part of Gt.
+ *
+ * Gt is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * Gt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Gt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gt {
+// Keeps the @n_largest biggest named sizes that it is given, biggest first
+private class LargestList {
+    private class Entry {
+        public string name;
+        public uint64 size;
+    }
+
+    private GenericArray<Entry> entries = new GenericArray<Entry>();
+    private uint n_largest;
+
+    public LargestList(uint n_largest) {
+        this.n_largest = n_largest;
+    }
+
+    public void add(string name, uint64 size) {
+        if (entries.length == n_largest &&
+            (n_largest == 0 || entries[entries.length - 1].size >= size))
+            return;
+        var index = entries.length;
+        while (index > 0 && entries[index - 1].size < size)
+            index--;
+        entries.insert(index, new Entry() { name = name, size = size });
+        if (entries.length > n_largest)
+            entries.remove_index(entries.length - 1);
+    }
+
+    public Variant to_variant() {
+        var builder = new VariantBuilder(new VariantType("a(st)"));
+        entries.foreach((entry) => builder.add("(st)", entry.name, entry.size));
+        return builder.end();
+    }
+}
+
+// Adds up the numbers in gt_mock_file_get_memory_report()
+internal class MemoryReport {
+    // A range of addresses holding the contents of one or more files
+    private class Region {
+        public size_t start;
+        public size_t end;
+    }
+
+    private uint64 n_files = 0;
+    private uint64 metadata_bytes = 0;
+    private uint64 logical_bytes = 0;
+    private uint64 n_open_streams = 0;
+    private uint64 buffered_bytes = 0;
+    private GenericArray<Region> regions = new GenericArray<Region>();
+    private LargestList largest_files;
+    private LargestList largest_subtrees;
+
+    public MemoryReport(uint n_largest) {
+        largest_files = new LargestList(n_largest);
+        largest_subtrees = new LargestList(n_largest);
+    }
+
+    public void add_file(string path, size_t metadata_size, Bytes contents,
+        uint n_open_streams, uint64 buffered_bytes)
+    {
+        n_files++;
+        metadata_bytes += metadata_size;
+        logical_bytes += contents.get_size();
+        this.n_open_streams += n_open_streams;
+        this.buffered_bytes += buffered_bytes;
+        largest_files.add(path, contents.get_size());
+        if (contents.get_size() > 0) {
+            var start = (size_t) contents.get_data();
+            regions.add(new Region() { start = start, end = start + contents.get_size() });
+        }
+    }
+
+    public void add_subtree(string path, uint64 size) {
+        largest_subtrees.add(path, size);
+    }
+
+    // Contents that share memory, because they are the same GBytes or slices
+    // of the same buffer, are only counted once
+    private uint64 get_resident_bytes() {
+        regions.sort((a, b) => a.start < b.start ? -1 : (a.start > b.start ? 1 : 0));
+        uint64 total = 0;
+        size_t covered_until = 0;
+        regions.foreach((region) => {
+            if (region.end <= covered_until)
+                return;
+            total += region.end - size_t.max(region.start, covered_until);
+            covered_until = region.end;
+        });
+        return total;
+    }
+
+    public Variant to_variant() {
+        var dict = new VariantDict();
+        dict.insert_value("n-files", new Variant.uint64(n_files));
+        dict.insert_value("metadata-bytes", new Variant.uint64(metadata_bytes));
+        dict.insert_value("logical-bytes", new Variant.uint64(logical_bytes));
+        dict.insert_value("resident-bytes", new Variant.uint64(get_resident_bytes()));
+        dict.insert_value("n-open-streams", new Variant.uint64(n_open_streams));
+        dict.insert_value("buffered-bytes", new Variant.uint64(buffered_bytes));
+        dict.insert_value("largest-files", largest_files.to_variant());
+        dict.insert_value("largest-subtrees", largest_subtrees.to_variant());
+        return dict.end();
+    }
+}
+}  // namespace Gt
@@ -0,0 +1,393 @@
+/*
+ * Copyright 2026 The Gt authors
+ *
+ * This file is part of Gt.
+ *
+ * Gt is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * Gt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Gt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gt {
+// Layout of the start of the shared memory. All offsets are from the start of
+// the mapping, so that they mean the same thing in every process.
+private struct ArenaHeader {
+    public uint32 magic;
+    public uint32 n_slots;
+    public uint64 size;
+    public uint64 data_start;
+    public uint64 data_used;
+    public int writer_lock;  // pid of the process that is storing, or 0
+}
+
+// One entry in the node table. The entry is protected by a sequence lock:
+// the writer makes seq odd while it changes the entry, and readers retry if
+// seq was odd or changed while they were reading. The key follows the struct.
+private struct ArenaSlot {
+    public int seq;
+    public uint32 flags;
+    public uint64 version;
+    public uint64 offset;
+    public uint64 length;
+}
+
+internal struct ArenaEntry {
+    public Bytes contents;
+    public bool exists;
+    public uint64 version;
+}
+
+/**
+ * Shared memory holding mock files for several processes
+ *
+ * Mock files normally live in the memory of one process, so a subprocess or a
+ * forked worker can't see them.
+ * Assign a mock arena to a #GtMockFile with gt_mock_file_set_arena() and the
+ * contents and existence of that file and its descendants are also kept in
+ * shared memory.
+ *
+ * Another process can then open the same files by URI, through the Gt GIO
+ * module, if it is given the arena's file descriptor in the
+ * `GT_MOCK_ARENA_FD` environment variable; use
+ * gt_mock_arena_prepare_launcher() to arrange this for a #GSubprocess.
+ * Forked workers inherit the arena and can keep using the same mock files.
+ * Changes made in either process are seen by the other the next time it
+ * accesses the file.
+ *
+ * Files are shared by URI, not as a tree: a process only sees the files whose
+ * URIs it is given, not their parents or children.
+ * Reading from the arena doesn't take any lock.
+ * Every change to a file's contents uses up more of the arena's space, until
+ * it fills up; then the space of contents that were replaced is reclaimed by
+ * compacting the arena.
+ * If a process dies while storing a file, the next process that stores one
+ * takes over, and the file that was being stored becomes empty.
+ */
+public class MockArena : Object {
+    /**
+     * Name of the environment variable that holds the number of the file
+     * descriptor of the arena in a child process.
+     */
+    public const string FD_ENVIRONMENT_VARIABLE = "GT_MOCK_ARENA_FD";
+
+    private const uint32 MAGIC = 0x52415447;  // "GTAR"
+    private const size_t SLOT_SIZE = 128;
+    private const size_t MAX_KEY_LENGTH = SLOT_SIZE - sizeof(ArenaSlot) - 1;
+    private const uint32 SLOT_IN_USE = 1 << 0;
+    private const uint32 SLOT_EXISTS = 1 << 1;
+
+    private uint8 *mapping = null;
+    private ArenaHeader *header = null;
+
+    /**
+     * The file descriptor of the memory that the arena lives in.
+     */
+    public int fd { get; private set; default = -1; }
+
+    /**
+     * Total size of the arena in bytes.
+     */
+    public size_t size { get; private set; }
+
+    /**
+     * Maximum number of mock files that the arena can hold.
+     */
+    public uint n_slots { get { return header->n_slots; } }
+
+    /**
+     * Creates a new, empty mock arena.
+     *
+     * @param size Total size of the arena in bytes, including the contents of
+     * all the files that will be stored in it
+     * @param n_slots Maximum number of mock files in the arena
+     * @return the new #GtMockArena
+     * @throws IOError if @n_slots is 0 or the slots don't fit in @size, or if
+     * the shared memory could not be created
+     */
+    public MockArena(size_t size = 64 * 1024 * 1024, uint n_slots = 1024)
+        throws IOError
+    {
+        if (n_slots == 0)
+            throw new IOError.INVALID_ARGUMENT("Mock arena must hold at least one file.");
+        if (n_slots > (size_t.MAX - sizeof(ArenaHeader)) / SLOT_SIZE)
+            throw new IOError.INVALID_ARGUMENT("Mock arena can't hold %u files.",
+                n_slots);
+        var data_start = sizeof(ArenaHeader) + n_slots * SLOT_SIZE;
+        if (size < data_start)
+            throw new IOError.INVALID_ARGUMENT("Mock arena is too small for %u files.",
+                n_slots);
+        fd = Memfd.create_shared("gt-mock-arena");
+        if (Posix.ftruncate(fd, (Posix.off_t) size) == -1)
+            throw Memfd.error_from_errno("Could not size mock arena");
+        map(size);
+        // The new shared memory is zero-filled, so all slots start out unused
+        header->magic = MAGIC;
+        header->n_slots = n_slots;
+        header->size = size;
+        header->data_start = data_start;
+        header->data_used = 0;
+    }
+
+    /**
+     * Attaches to an existing mock arena created by another process.
+     *
+     * @param fd File descriptor of the arena; the arena takes ownership of it
+     * @return the #GtMockArena
+     * @throws IOError if @fd is not a mock arena
+     */
+    public MockArena.attach(int fd) throws IOError {
+        this.fd = fd;
+        Posix.Stat stat;
+        if (Posix.fstat(fd, out stat) == -1)
+            throw Memfd.error_from_errno("Could not attach to mock arena");
+        if ((size_t) stat.st_size < sizeof(ArenaHeader))
+            throw new IOError.INVALID_DATA("File descriptor %d is not a mock arena.", fd);
+        map((size_t) stat.st_size);
+        if (header->magic != MAGIC || header->size != size)
+            throw new IOError.INVALID_DATA("File descriptor %d is not a mock arena.", fd);
+        // The tables are read without further bounds checks, so a corrupt
+        // header must not point outside the mapping
+        var n_slots = header->n_slots;
+        if (n_slots == 0 ||
+            n_slots > (size - sizeof(ArenaHeader)) / SLOT_SIZE ||
+            header->data_start != sizeof(ArenaHeader) + n_slots * SLOT_SIZE ||
+            header->data_used > size - header->data_start)
+            throw new IOError.INVALID_DATA("Mock arena in file descriptor %d is corrupt.",
+                fd);
+    }
+
+    // Attaches to the arena given by FD_ENVIRONMENT_VARIABLE, if any
+    internal static MockArena? from_environment() {
+        var fd_string = Environment.get_variable(FD_ENVIRONMENT_VARIABLE);
+        if (fd_string == null)
+            return null;
+        try {
+            return new MockArena.attach(int.parse(fd_string));
+        } catch (IOError e) {
+            warning("%s is set, but: %s", FD_ENVIRONMENT_VARIABLE, e.message);
+            return null;
+        }
+    }
+
+    ~MockArena() {
+        if (mapping != null)
+            Posix.munmap(mapping, size);
+        if (fd != -1)
+            Posix.close(fd);
+    }
+
+    private void map(size_t size) throws IOError {
+        var retval = Posix.mmap(null, size, Posix.PROT_READ | Posix.PROT_WRITE,
+            Posix.MAP_SHARED, fd, 0);
+        if (retval == Posix.MAP_FAILED)
+            throw Memfd.error_from_errno("Could not map mock arena");
+        mapping = (uint8 *) retval;
+        header = (ArenaHeader *) mapping;
+        this.size = size;
+    }
+
+    /**
+     * Sets up @launcher so that the processes it spawns can see the mock files
+     * in this arena.
+     *
+     * @param launcher The launcher for the child processes
+     * @param child_fd File descriptor number that the arena gets in the child
+     */
+    public void prepare_launcher(SubprocessLauncher launcher, int child_fd = 3) {
+        launcher.take_fd(Posix.dup(fd), child_fd);
+        launcher.setenv(FD_ENVIRONMENT_VARIABLE, child_fd.to_string(), true);
+    }
+
+    private ArenaSlot *get_slot(uint index) {
+        return (ArenaSlot *) (mapping + sizeof(ArenaHeader) + index * SLOT_SIZE);
+    }
+
+    private static char *get_key(ArenaSlot *slot) {
+        return (char *) slot + sizeof(ArenaSlot);
+    }
+
+    // Finds the slot for @key by open addressing, or the unused slot where it
+    // would go, or null if the table is full
+    private ArenaSlot *find_slot(string key) {
+        var n = header->n_slots;
+        var start = key.hash() % n;
+        for (uint probe = 0; probe < n; probe++) {
+            var slot = get_slot((start + probe) % n);
+            // Keys are written once, before the slot is marked in use
+            if ((AtomicUint.get(ref slot->flags) & SLOT_IN_USE) == 0)
+                return slot;
+            if (Posix.strcmp((string) get_key(slot), key) == 0)
+                return slot;
+        }
+        return null;
+    }
+
+    // Reads the entry for @key without locking. Returns false if there is no
+    // entry, or if its version is still @known_version, so that the contents
+    // are only copied when they have changed.
+    internal bool lookup(string key, uint64 known_version, out ArenaEntry entry) {
+        entry = ArenaEntry();
+        var slot = find_slot(key);
+        if (slot == null)
+            return false;
+
+        // The data may be moved when the arena is compacted, so it is copied
+        // inside the sequence lock as well
+        uint32 flags;
+        uint64 version;
+        uint8[]? data = null;
+        for (var spins = 1; ; spins++) {
+            var seq = AtomicInt.get(ref slot->seq);
+            if ((seq & 1) != 0) {
+                // The writer may have died in the middle of changing the slot
+                if (spins % 100 == 0)
+                    recover_if_writer_died();
+                Thread.yield();
+                continue;
+            }
+            flags = slot->flags;
+            version = slot->version;
+            var offset = slot->offset;
+            var length = slot->length;
+            if ((flags & SLOT_IN_USE) != 0 && version != known_version &&
+                offset <= header->size && length <= header->size - offset)
+            {
+                data = new uint8[(size_t) length];
+                Memory.copy(data, mapping + offset, (size_t) length);
+            }
+            if (AtomicInt.get(ref slot->seq) == seq)
+                break;
+        }
+        if ((flags & SLOT_IN_USE) == 0 || version == known_version)
+            return false;
+
+        entry.contents = new Bytes.take((owned) data);
+        entry.exists = (flags & SLOT_EXISTS) != 0;
+        entry.version = version;
+        return true;
+    }
+
+    // Takes the writer lock. The lock word holds the pid of its owner, so if
+    // the owner died while holding it, another process can take over.
+    private void lock_writer() {
+        var pid = (int) Posix.getpid();
+        for (var spins = 1; ; spins++) {
+            if (AtomicInt.compare_and_exchange(ref header->writer_lock, 0, pid))
+                return;
+            if (spins % 100 == 0)
+                recover_if_writer_died();
+            Thread.yield();
+        }
+    }
+
+    private void recover_if_writer_died() {
+        var owner = AtomicInt.get(ref header->writer_lock);
+        if (owner == 0 || !owner_died(owner))
+            return;
+        var pid = (int) Posix.getpid();
+        if (!AtomicInt.compare_and_exchange(ref header->writer_lock, owner, pid))
+            return;
+        recover();
+        AtomicInt.set(ref header->writer_lock, 0);
+    }
+
+    private static bool owner_died(int owner) {
+        return Posix.kill((Posix.pid_t) owner, 0) == -1 &&
+            Posix.errno == Posix.ESRCH;
+    }
+
+    // Repairs the arena after a writer died while holding the lock. A slot
+    // that was being changed may be inconsistent, so it is emptied.
+    private void recover() {
+        for (uint ix = 0; ix < header->n_slots; ix++) {
+            var slot = get_slot(ix);
+            if ((AtomicInt.get(ref slot->seq) & 1) == 0)
+                continue;
+            slot->offset = header->data_start;
+            slot->length = 0;
+            slot->version++;
+            AtomicInt.inc(ref slot->seq);
+        }
+        header->data_used = uint64.min(header->data_used,
+            header->size - header->data_start);
+    }
+
+    // Moves the contents of all slots together at the start of the data area,
+    // reclaiming the space of contents that were replaced. Must be called
+    // with the writer lock held.
+    private void compact() {
+        // Slots in order of the offset of their data, so that moving each one
+        // down never overwrites data that hasn't been moved yet
+        var order = new uint[header->n_slots];
+        var n_used = 0;
+        for (uint ix = 0; ix < header->n_slots; ix++) {
+            var slot = get_slot(ix);
+            if ((slot->flags & SLOT_IN_USE) == 0)
+                continue;
+            var pos = n_used++;
+            for (; pos > 0 && get_slot(order[pos - 1])->offset > slot->offset; pos--)
+                order[pos] = order[pos - 1];
+            order[pos] = ix;
+        }
+
+        var cursor = header->data_start;
+        for (var ix = 0; ix < n_used; ix++) {
+            var slot = get_slot(order[ix]);
+            if (slot->offset != cursor) {
+                AtomicInt.inc(ref slot->seq);
+                Memory.move(mapping + cursor, mapping + slot->offset,
+                    (size_t) slot->length);
+                slot->offset = cursor;
+                AtomicInt.inc(ref slot->seq);
+            }
+            cursor += slot->length;
+        }
+        header->data_used = cursor - header->data_start;
+    }
+
+    // Publishes new contents for @key, and returns the entry's new version
+    internal uint64 store(string key, Bytes contents, bool exists) throws IOError {
+        if (key.length > MAX_KEY_LENGTH)
+            throw new IOError.FILENAME_TOO_LONG("Mock file ID is too long for " +
+                "a mock arena.");
+
+        // Writers exclude each other with a lock in the shared memory
+        lock_writer();
+        try {
+            var slot = find_slot(key);
+            if (slot == null)
+                throw new IOError.NO_SPACE("Mock arena has no free slots.");
+            var length = contents.get_size();
+            var offset = header->data_start + header->data_used;
+            if (offset + length > header->size) {
+                compact();
+                offset = header->data_start + header->data_used;
+            }
+            if (offset + length > header->size)
+                throw new IOError.NO_SPACE("Mock arena is full.");
+            Memory.copy(mapping + offset, contents.get_data(), length);
+            header->data_used += length;
+
+            AtomicInt.inc(ref slot->seq);
+            if ((slot->flags & SLOT_IN_USE) == 0)
+                Memory.copy(get_key(slot), key, key.length + 1);
+            slot->offset = offset;
+            slot->length = length;
+            slot->version++;
+            AtomicUint.set(ref slot->flags, SLOT_IN_USE | (exists ? SLOT_EXISTS : 0));
+            AtomicInt.inc(ref slot->seq);
+            return slot->version;
+        } finally {
+            AtomicInt.set(ref header->writer_lock, 0);
+        }
+    }
+}
+}  // namespace Gt
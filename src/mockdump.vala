@@ -0,0 +1,195 @@
+/*
+ * Copyright 2026 The Gt authors
+ *
+ * This file is part of Gt.
+ *
+ * Gt is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * Gt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Gt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gt {
+// Everything about a mock file that goes into a dump, apart from its place in
+// the tree
+internal struct MockFileState {
+    public string id;
+    public string? basename;
+    public bool exists;
+    public Bytes contents;
+    public int64 creation_time;
+    public int64 modification_time;
+    public uint n_read_calls;
+    public uint n_write_calls;
+    public uint64 n_bytes_read;
+    public uint64 n_bytes_written;
+}
+
+// Binary dumps of mock trees. A dump consists of:
+//  - the 8-byte magic number,
+//  - the length of the metadata, as a little-endian uint64,
+//  - the metadata, a GVariant of type METADATA_TYPE,
+//  - padding up to a multiple of 8 bytes,
+//  - the contents of the files, each distinct blob stored only once.
+// The metadata lists the files in pre-order, each with the index of its
+// parent (-1 for the root) and the index of its contents in the blob table.
+// The blob table gives the offset of each blob from the end of the padding,
+// and its length.
+namespace MockDump {
+    private const string MAGIC = "GTDUMP\x00\x01";
+    private const size_t HEADER_SIZE = 16;
+    private const string NODE_TYPE = "(imssbuxxuutt)";
+    private const string METADATA_TYPE = "(a" + NODE_TYPE + "a(tt))";
+
+    private size_t align(size_t offset) {
+        return (offset + 7) & ~((size_t) 7);
+    }
+
+    private class Writer {
+        private VariantBuilder nodes = new VariantBuilder(new VariantType("a" + NODE_TYPE));
+        private VariantBuilder blob_table = new VariantBuilder(new VariantType("a(tt)"));
+        private GenericArray<Bytes> blobs = new GenericArray<Bytes>();
+        // Index of each distinct blob, plus one, so that 0 means not found
+        private HashTable<Bytes, int> blob_indices =
+            new HashTable<Bytes, int>(Bytes.hash, Bytes.equal);
+        private uint64 blobs_size = 0;
+        private int n_nodes = 0;
+
+        private uint add_blob(Bytes contents) {
+            var index = blob_indices[contents];
+            if (index != 0)
+                return index - 1;
+            blobs.add(contents);
+            blob_indices[contents] = blobs.length;
+            blob_table.add("(tt)", blobs_size, (uint64) contents.get_size());
+            blobs_size += contents.get_size();
+            return blobs.length - 1;
+        }
+
+        public void add_subtree(MockFile file, int parent) {
+            var state = file.get_state();
+            var index = n_nodes++;
+            nodes.add(NODE_TYPE, parent, state.basename, state.id, state.exists,
+                add_blob(state.contents), state.creation_time,
+                state.modification_time, state.n_read_calls, state.n_write_calls,
+                state.n_bytes_read, state.n_bytes_written);
+            // Children are kept newest first; restoring them in the opposite
+            // order gives the same order back. Unnamed children can't be
+            // restored, so they are left out, as in gt_mock_file_export()
+            for (unowned List<MockFile> iter = file.get_children().last();
+                iter != null; iter = iter.prev) {
+                if (iter.data.get_basename() != null)
+                    add_subtree(iter.data, index);
+            }
+        }
+
+        // Writes the whole dump with one vectored write. The contents of the
+        // files are written straight from their GBytes, without being copied.
+        public void write(OutputStream stream, Cancellable? cancellable)
+            throws IOError
+        {
+            var metadata = new Variant.tuple({ nodes.end(), blob_table.end() });
+            var metadata_data = metadata.get_data_as_bytes();
+
+            var header = new uint8[HEADER_SIZE];
+            Memory.copy(header, MAGIC, 8);
+            var length_le = ((uint64) metadata_data.get_size()).to_little_endian();
+            Memory.copy((uint8 *) header + 8, &length_le, sizeof(uint64));
+            var padding = new uint8[align(HEADER_SIZE + metadata_data.get_size()) -
+                HEADER_SIZE - metadata_data.get_size()];
+
+            var vectors = new OutputVector[3 + blobs.length];
+            vectors[0] = { header, header.length };
+            vectors[1] = { metadata_data.get_data(), metadata_data.get_size() };
+            vectors[2] = { padding, padding.length };
+            for (var ix = 0; ix < blobs.length; ix++)
+                vectors[3 + ix] = { blobs[ix].get_data(), blobs[ix].get_size() };
+            size_t bytes_written;
+            stream.writev_all(vectors, out bytes_written, cancellable);
+        }
+    }
+
+    internal void write(MockFile root, OutputStream stream,
+        Cancellable? cancellable) throws IOError
+    {
+        var writer = new Writer();
+        writer.add_subtree(root, -1);
+        writer.write(stream, cancellable);
+    }
+
+    // Rebuilds a mock tree from a dump. Local dumps are mapped into memory,
+    // and the contents of the files are slices of the mapping, so nothing is
+    // copied and the contents are only paged in when they are read.
+    internal MockFile read(File source, Cancellable? cancellable) throws Error {
+        Bytes dump;
+        var path = source.get_path();
+        if (path != null)
+            dump = new MappedFile(path, false).get_bytes();
+        else
+            dump = source.load_bytes(cancellable, null);
+        var name = source.get_parse_name();
+
+        var data = (uint8 *) dump.get_data();
+        var size = dump.get_size();
+        if (size < HEADER_SIZE || Memory.cmp(data, MAGIC, 8) != 0)
+            throw new IOError.INVALID_DATA("%s is not a mock tree dump.", name);
+        uint64 metadata_length;
+        Memory.copy(&metadata_length, data + 8, sizeof(uint64));
+        metadata_length = uint64.from_little_endian(metadata_length);
+        if (metadata_length > size - HEADER_SIZE)
+            throw new IOError.INVALID_DATA("Mock tree dump %s is truncated.", name);
+        var blobs_start = align(HEADER_SIZE + (size_t) metadata_length);
+        var blobs_size = size - size_t.min(blobs_start, size);
+
+        var metadata = new Variant.from_bytes(new VariantType(METADATA_TYPE),
+            new Bytes.from_bytes(dump, HEADER_SIZE, (size_t) metadata_length),
+            false);
+        var blob_table = metadata.get_child_value(1);
+        var blobs = new Bytes[blob_table.n_children()];
+        for (var ix = 0; ix < blobs.length; ix++) {
+            uint64 offset, length;
+            blob_table.get_child(ix, "(tt)", out offset, out length);
+            if (offset > blobs_size || length > blobs_size - offset)
+                throw new IOError.INVALID_DATA("Mock tree dump %s is truncated.", name);
+            blobs[ix] = new Bytes.from_bytes(dump, blobs_start + (size_t) offset,
+                (size_t) length);
+        }
+
+        var node_list = metadata.get_child_value(0);
+        var files = new MockFile[node_list.n_children()];
+        // Parent index and basename of every file, to catch siblings that
+        // share a name
+        var names = new GenericSet<string>(str_hash, str_equal);
+        if (files.length == 0)
+            throw new IOError.INVALID_DATA("Mock tree dump %s is empty.", name);
+        for (var ix = 0; ix < files.length; ix++) {
+            int parent;
+            uint blob;
+            var state = MockFileState();
+            node_list.get_child(ix, NODE_TYPE, out parent, out state.basename,
+                out state.id, out state.exists, out blob, out state.creation_time,
+                out state.modification_time, out state.n_read_calls,
+                out state.n_write_calls, out state.n_bytes_read,
+                out state.n_bytes_written);
+            if (parent >= ix || (parent < 0) != (ix == 0) || blob >= blobs.length)
+                throw new IOError.INVALID_DATA("Mock tree dump %s is corrupt.", name);
+            if (parent >= 0) {
+                var key = "%d/%s".printf(parent, state.basename ?? "");
+                if (state.basename == null || key in names)
+                    throw new IOError.INVALID_DATA("Mock tree dump %s is corrupt.", name);
+                names.add(key);
+            }
+            state.contents = blobs[blob];
+            files[ix] = MockFile.restore(parent < 0 ? null : files[parent], state);
+        }
+        return files[0];
+    }
+}
+}  // namespace Gt
@@ -74,6 +74,56 @@ public class MockFile : Object, File {
     // MockFile keeps references to its parent file and its direct children
     private MockFile? ancestor;
     private List<MockFile> children;
+    // The mock filesystem that owns this file, if any; it keeps this file alive
+    internal unowned MockFilesystem? filesystem = null;
+    private Bytes _contents = new Bytes(new uint8[0]);
+    private MockMount? own_mount = null;  // only set on the root of a mount
+    private string? cached_etag = null;  // computed from contents on demand
+    // Prebuilt info with every attribute that query_info() can return, except
+    // the ones that are expensive or change independently of this file
+    private FileInfo? info_template = null;  // protected by info_mutex
+    private Mutex info_mutex = Mutex();
+    private int64 creation_time = get_real_time();
+    private int64 modification_time = get_real_time();
+    // Disk usage of this file by itself, and totals for this file and all of
+    // its descendants, kept up to date so that measuring is O(1)
+    private DiskUsage own_usage = DiskUsage();
+    private DiskUsage subtree_usage = DiskUsage();
+    // Nul-terminated copy of the contents, or a buffer that the contents are
+    // a slice of, kept until the contents change
+    private Bytes? nul_terminated_contents;
+    private int utf8_valid = -1;  // -1 means not checked yet
+    private uint _n_open_writers = 0;
+    private uint _n_open_readers = 0;
+    // Data written to output streams on this file that aren't closed yet
+    private int64 buffered_bytes = 0;
+    // In MockFileStorage.MEMFD, the memfd holding the contents, if it has been
+    // created yet, and the contents that it holds
+    private int memfd = -1;
+    private Bytes? memfd_contents = null;
+    private MockArena? _arena = null;
+    // Version of this file's entry in the mock arena that the contents are
+    // up to date with, if the file is in an arena
+    private uint64 arena_version = 0;
+    private bool syncing_from_arena = false;
+    // The arena found by find_arena(), valid as long as arena_generation is
+    // still the same; it changes whenever any arena is assigned or any tree
+    // changes shape
+    private MockArena? cached_arena = null;
+    private int cached_arena_generation = -1;
+    private static int arena_generation = 0;
+
+    // Parsed attribute strings, shared between all mock files
+    private static HashTable<string, FileAttributeMatcher>? matcher_cache = null;
+    private static Mutex matcher_cache_mutex;
+    private const uint MAX_CACHED_MATCHERS = 64;
+    // I/O counters for streams opened on this file, which may be used from
+    // several threads; all four are protected by io_counters_mutex
+    private Mutex io_counters_mutex = Mutex();
+    private uint _n_read_calls = 0;
+    private uint _n_write_calls = 0;
+    private uint64 _n_bytes_read = 0;
+    private uint64 _n_bytes_written = 0;
 
     /* Constructors */
 
@@ -99,6 +149,12 @@ public class MockFile : Object, File {
 
     construct {
         id = Checksum.compute_for_string(ChecksumType.MD5, "%p".printf(this), -1);
+        update_usage();
+    }
+
+    ~MockFile() {
+        if (memfd != -1)
+            Posix.close(memfd);
     }
 
     /* GFile implementations */
@@ -151,6 +207,40 @@ public class MockFile : Object, File {
         if (child.ancestor != null)
             critical("Bookkeeping failure in GMockFile");
         child.ancestor = parent;
+        AtomicInt.inc(ref arena_generation);
+        // Files joining a tree that is owned by a mock filesystem are owned
+        // by it too
+        if (parent.filesystem == null && child.filesystem != null)
+            child.filesystem.adopt(parent);
+        else if (child.filesystem == null && parent.filesystem != null)
+            parent.filesystem.adopt(child);
+        parent.propagate_usage(child.subtree_usage);
+        // The parent may have just started counting as a directory
+        parent.update_usage();
+    }
+
+    // Takes this file's own contents out of the usage of the mount that it is
+    // on, before the tree is taken apart. The root of a mount keeps its own
+    // contents, since it stays attached to the mount.
+    internal void leave_mount() {
+        if (own_mount != null)
+            return;
+        var mount = find_mount();
+        if (mount != null)
+            mount.adjust_used(-own_usage.apparent_bytes);
+    }
+
+    // Breaks the references between this file and its parent and children.
+    // Files that are still referenced elsewhere stay usable on their own, so
+    // their totals of disk usage are reset to count only themselves.
+    internal void detach_from_tree() {
+        ancestor = null;
+        children = null;
+        subtree_usage = own_usage;
+        // Without its children, it is no longer a directory
+        update_usage();
+        invalidate_info();
+        AtomicInt.inc(ref arena_generation);
     }
 
     // If the mock file was created through g_file_get_child() or similar,
@@ -209,6 +299,137 @@ public class MockFile : Object, File {
         return string.joinv(Path.DIR_SEPARATOR_S, components);
     }
 
+    // Helper function: returns the path of this file within its mock tree,
+    // built from the basenames of its ancestors. Used for matching against
+    // fault injection patterns.
+    internal string get_mock_path() {
+        var path = "";
+        for (var file = this; file != null; file = file.ancestor) {
+            if (file.basename != null)
+                path = Path.DIR_SEPARATOR_S + file.basename + path;
+        }
+        return path == "" ? Path.DIR_SEPARATOR_S : path;
+    }
+
+    // Consults the nearest fault injector, if any, before performing
+    // @operation. Throws the injected error, or returns MockFault.SHORT_IO if
+    // the caller should transfer fewer bytes than were requested.
+    internal MockFault inject_fault(MockOperation operation) throws IOError {
+        for (var file = this; file != null; file = file.ancestor) {
+            if (file.fault_injector != null)
+                return file.fault_injector.check(operation, get_mock_path());
+        }
+        return MockFault.NONE;
+    }
+
+    // Attaches @mount to this file and returns the total size of the contents
+    // of this file and its descendants, which the mount starts out using
+    internal uint64 attach_mount(MockMount mount) {
+        own_mount = mount;
+        return subtree_usage.apparent_bytes;
+    }
+
+    // Mock files that have children are directories
+    private bool is_directory() {
+        return children != null;
+    }
+
+    // Recomputes this file's own disk usage after it has changed, and
+    // propagates the difference to the totals of this file and its ancestors.
+    // This costs O(depth).
+    private void update_usage() {
+        var usage = DiskUsage();
+        if (_exists) {
+            usage.apparent_bytes = _contents.length;
+            usage.allocated_bytes = (usage.apparent_bytes + 4095) / 4096 * 4096;
+            if (is_directory())
+                usage.dirs = 1;
+            else
+                usage.files = 1;
+        }
+        propagate_usage(usage.subtract(own_usage));
+        own_usage = usage;
+    }
+
+    // Adds @delta to the totals of this file and its ancestors, and to the
+    // usage of the nearest mock mount
+    private void propagate_usage(DiskUsage delta) {
+        var mount_adjusted = false;
+        for (var file = this; file != null; file = file.ancestor) {
+            file.subtree_usage = file.subtree_usage.add(delta);
+            if (file.own_mount != null && !mount_adjusted) {
+                file.own_mount.adjust_used(delta.apparent_bytes);
+                mount_adjusted = true;
+            }
+        }
+    }
+
+    // Returns the mount that this file is on, if any
+    internal MockMount? find_mount() {
+        for (var file = this; file != null; file = file.ancestor) {
+            if (file.own_mount != null)
+                return file.own_mount;
+        }
+        return null;
+    }
+
+    // Returns the mock arena that this file is in, if any. This is called
+    // every time the contents are read, so the result is cached.
+    private MockArena? find_arena() {
+        var generation = AtomicInt.get(ref arena_generation);
+        if (cached_arena_generation == generation)
+            return cached_arena;
+        cached_arena = null;
+        for (var file = this; file != null; file = file.ancestor) {
+            if (file._arena != null) {
+                cached_arena = file._arena;
+                break;
+            }
+        }
+        cached_arena_generation = generation;
+        return cached_arena;
+    }
+
+    // Picks up changes that another process made to this file in the arena
+    private void sync_from_arena() {
+        var arena = find_arena();
+        ArenaEntry entry;
+        if (arena == null || !arena.lookup(id, arena_version, out entry))
+            return;
+        arena_version = entry.version;
+        syncing_from_arena = true;
+        _exists = entry.exists;
+        contents = entry.contents;
+        syncing_from_arena = false;
+    }
+
+    private void publish_to_arena() throws IOError {
+        if (syncing_from_arena)
+            return;
+        var arena = find_arena();
+        if (arena != null)
+            arena_version = arena.store(id, _contents, _exists);
+    }
+
+    // For changes that can't fail, such as setting the contents property. A
+    // full arena is reported without making the test fail; the other
+    // processes just keep seeing the old contents.
+    private void try_publish_to_arena() {
+        try {
+            publish_to_arena();
+        } catch (IOError e) {
+            message("Mock file %s was changed but could not be shared with " +
+                "other processes: %s", get_mock_path(), e.message);
+        }
+    }
+
+    // Throws if the file is on a read-only mount
+    private void check_writable() throws IOError {
+        var mount = find_mount();
+        if (mount != null && mount.read_only)
+            throw new IOError.READ_ONLY("This mock file is on a read-only mock mount.");
+    }
+
     // Helper function: Returns a child (transfer full) if one exists with
     // @basename
     private MockFile? get_child_with_basename(string basename) {
@@ -257,6 +478,7 @@ public class MockFile : Object, File {
     // This would rename the file; return a reference to this same mock file
     public File set_display_name(string display_name, Cancellable? cancellable) {
         basename = display_name;
+        invalidate_info();
         return this;
     }
 
@@ -276,36 +498,134 @@ public class MockFile : Object, File {
         if (!exists)
             throw new IOError.NOT_FOUND("If you want a mock file to exist, " +
                 "create it with its exists property set to true.");
-
-        var retval = new FileInfo();
-
-        // Make sure we don't set any unwanted attributes
-        var matcher = new FileAttributeMatcher(attributes);
+        inject_fault(MockOperation.QUERY_INFO);
+
+        // The template is replaced rather than changed, so it can be copied
+        // after letting go of the lock
+        info_mutex.lock();
+        if (info_template == null)
+            info_template = build_info_template();
+        var template = info_template;
+        info_mutex.unlock();
+        var retval = template.dup();
+
+        // Make sure we don't return any unwanted attributes; this removes the
+        // ones from the template that don't match
+        var matcher = get_attribute_matcher(attributes);
         retval.set_attribute_mask(matcher);
 
-        if (matcher.matches(FileAttribute.STANDARD_TYPE))
-            retval.set_attribute_uint32(FileAttribute.STANDARD_TYPE,
-                FileType.REGULAR);
+        // The etag requires hashing the contents if it isn't cached yet, so
+        // only compute it if asked
+        if (matcher.matches(FileAttribute.ETAG_VALUE))
+            retval.set_attribute_string(FileAttribute.ETAG_VALUE, etag);
+
+        if (matcher.matches(FileAttribute.ACCESS_CAN_WRITE)) {
+            var mount = find_mount();
+            retval.set_attribute_boolean(FileAttribute.ACCESS_CAN_WRITE,
+                mount == null || !mount.read_only);
+        }
 
-        if (basename != null && matcher.matches(FileAttribute.STANDARD_DISPLAY_NAME))
-            retval.set_attribute_string(FileAttribute.STANDARD_DISPLAY_NAME,
-                basename);
+        return retval;
+    }
 
-        // FIXME: etags are blank for now
-        if (matcher.matches(FileAttribute.ETAG_VALUE))
-            retval.set_attribute_string(FileAttribute.ETAG_VALUE, "");
+    // Makes the next query_info() build the file info again
+    private void invalidate_info() {
+        info_mutex.lock();
+        info_template = null;
+        info_mutex.unlock();
+    }
 
+    // Helper function: returns a parsed matcher for @attributes, parsing it
+    // only the first time any mock file is queried with that string. Code
+    // usually queries a handful of attribute strings over and over, so the
+    // cache is simply emptied if it ever gets bigger than that.
+    private static FileAttributeMatcher get_attribute_matcher(string attributes) {
+        matcher_cache_mutex.lock();
+        if (matcher_cache == null)
+            matcher_cache = new HashTable<string, FileAttributeMatcher>(str_hash, str_equal);
+        FileAttributeMatcher? retval = matcher_cache[attributes];
+        if (retval == null) {
+            retval = new FileAttributeMatcher(attributes);
+            if (matcher_cache.size() >= MAX_CACHED_MATCHERS)
+                matcher_cache.remove_all();
+            matcher_cache[attributes] = retval;
+        }
+        matcher_cache_mutex.unlock();
         return retval;
     }
 
+    private FileInfo build_info_template() {
+        var info = new FileInfo();
+        var name = get_basename();
+        var size = _contents.length;
+
+        info.set_file_type(FileType.REGULAR);
+        info.set_name(name);
+        info.set_display_name(name);
+        info.set_edit_name(name);
+        info.set_is_hidden(name.has_prefix("."));
+        info.set_attribute_boolean(FileAttribute.STANDARD_IS_BACKUP,
+            name.has_suffix("~"));
+        info.set_size(size);
+        // Pretend to allocate whole 4 KiB blocks, like most disk filesystems
+        info.set_attribute_uint64(FileAttribute.STANDARD_ALLOCATED_SIZE,
+            ((uint64) size + 4095) / 4096 * 4096);
+
+        // Sniff at most the first 4 KiB, like GIO's local files do
+        bool uncertain;
+        string content_type;
+        if (size > 0)
+            content_type = ContentType.guess(name,
+                _contents.get_data()[0:int.min(size, 4096)], out uncertain);
+        else
+            content_type = ContentType.guess(name, null, out uncertain);
+        info.set_content_type(content_type);
+        info.set_attribute_string(FileAttribute.STANDARD_FAST_CONTENT_TYPE,
+            ContentType.guess(name, null, out uncertain));
+
+        info.set_attribute_string(FileAttribute.ID_FILE, id);
+        info.set_attribute_boolean(FileAttribute.ACCESS_CAN_READ, true);
+
+        set_time_attributes(info, FileAttribute.TIME_MODIFIED,
+            FileAttribute.TIME_MODIFIED_USEC, modification_time);
+        set_time_attributes(info, FileAttribute.TIME_ACCESS,
+            FileAttribute.TIME_ACCESS_USEC, modification_time);
+        set_time_attributes(info, FileAttribute.TIME_CHANGED,
+            FileAttribute.TIME_CHANGED_USEC, modification_time);
+        set_time_attributes(info, FileAttribute.TIME_CREATED,
+            FileAttribute.TIME_CREATED_USEC, creation_time);
+
+        return info;
+    }
+
+    private static void set_time_attributes(FileInfo info, string seconds_attribute,
+        string usec_attribute, int64 time)
+    {
+        info.set_attribute_uint64(seconds_attribute, time / TimeSpan.SECOND);
+        info.set_attribute_uint32(usec_attribute, (uint32) (time % TimeSpan.SECOND));
+    }
+
     public FileInfo query_filesystem_info(string attributes,
         Cancellable? cancellable = null) throws Error
     {
-        throw new IOError.NOT_SUPPORTED("Not yet implemented for mock files.");
+        var mount = find_mount();
+        if (mount == null)
+            throw new IOError.NOT_SUPPORTED("If you want to query filesystem " +
+                "info for a mock file, attach it to a GtMockMount.");
+
+        var retval = new FileInfo();
+        var matcher = get_attribute_matcher(attributes);
+        retval.set_attribute_mask(matcher);
+        mount.fill_filesystem_info(retval, matcher);
+        return retval;
     }
 
     public Mount find_enclosing_mount(Cancellable? cancellable = null) throws Error {
-        throw new IOError.NOT_SUPPORTED("Not yet implemented for mock files.");
+        var mount = find_mount();
+        if (mount == null)
+            throw new IOError.NOT_FOUND("If you want a mock file to have an " +
+                "enclosing mount, attach it to a GtMockMount.");
+        return mount;
     }
 
     public FileAttributeInfoList query_settable_attributes(Cancellable? cancellable = null)
@@ -346,8 +666,13 @@ public class MockFile : Object, File {
         if (!exists)
             throw new IOError.NOT_FOUND("If you want to read() a mock file, " +
                 "create it with its exists property set to true.");
-        var istream = new MemoryInputStream.from_bytes(contents);
-        return new MockFileInputStream(this, istream);
+        inject_fault(MockOperation.READ);
+        if (storage == MockFileStorage.MEMFD) {
+            ensure_memfd();
+            var fd = Memfd.reopen(memfd, Posix.O_RDONLY);
+            return new MockFdInputStream(this, contents, new MemfdInputStream(fd));
+        }
+        return new MockFileInputStream(this, contents);
     }
 
     public FileOutputStream append_to(FileCreateFlags flags,
@@ -362,15 +687,68 @@ public class MockFile : Object, File {
         if (exists)
             throw new IOError.EXISTS("If you want to call create() on a mock" +
                 "file, create it with its exists property set to false.");
+        check_writable();
+        inject_fault(MockOperation.CREATE);
         _exists = true;
-        var ostream = new MemoryOutputStream.resizable();
-        return new MockFileOutputStream(this, ostream);
+        invalidate_info();
+        update_usage();
+        publish_to_arena();
+        return create_output_stream();
     }
 
     public FileOutputStream replace(string? etag, bool make_backup,
-        FileCreateFlags flags, Cancellable? cancellable = null) throws Error
+        FileCreateFlags flags, // ignored
+        Cancellable? cancellable = null) throws Error
     {
-        throw new IOError.NOT_SUPPORTED("Not yet implemented for mock files.");
+        check_writable();
+        inject_fault(MockOperation.REPLACE);
+        if (exists && etag != null && etag != this.etag)
+            throw new IOError.WRONG_ETAG("The mock file's contents have " +
+                "changed since the etag was obtained.");
+        if (make_backup)
+            throw new IOError.CANT_CREATE_BACKUP("Backups are not supported " +
+                "for mock files.");
+        _exists = true;
+        invalidate_info();
+        update_usage();
+        publish_to_arena();
+        return create_output_stream();
+    }
+
+    private FileOutputStream create_output_stream() throws IOError {
+        if (storage == MockFileStorage.MEMFD && write_mode == MockWriteMode.STORE) {
+            var fd = Memfd.create(get_basename() ?? "gt-mock");
+            return new MockFdOutputStream(this, new MemfdOutputStream(fd));
+        }
+        var ostream = new MemoryOutputStream.resizable();
+        return new MockFileOutputStream(this, ostream);
+    }
+
+    // Makes sure that the memfd holds the current contents. If they were set
+    // directly rather than written through a stream, this copies them once,
+    // and from then on the contents are a mapping of the memfd.
+    private void ensure_memfd() throws IOError {
+        if (memfd != -1 && memfd_contents == _contents)
+            return;
+        var fd = Memfd.create(get_basename() ?? "gt-mock");
+        try {
+            Memfd.write_all(fd, _contents.get_data());
+            adopt_memfd(fd, Memfd.map(fd));
+        } catch (IOError e) {
+            Posix.close(fd);
+            throw e;
+        }
+        // Same data, so nothing else about the file changes
+        _contents = memfd_contents;
+    }
+
+    // Takes ownership of @fd as the storage of @contents, which must be a
+    // mapping of it
+    internal void adopt_memfd(int fd, Bytes contents) {
+        if (memfd != -1)
+            Posix.close(memfd);
+        memfd = fd;
+        memfd_contents = contents;
     }
 
     public bool @delete(Cancellable? cancellable = null) throws Error {
@@ -513,8 +891,65 @@ public class MockFile : Object, File {
 
     /* GFileIface functions with default implementations, e.g. async operations
     implemented in terms of running the sync operation in a different thread */
+
+    // Mock files keep their disk usage totals up to date, so there is no need
+    // to walk the tree
+    public bool measure_disk_usage(FileMeasureFlags flags,
+        Cancellable? cancellable,
+        FileMeasureProgressCallback? progress_callback,
+        out uint64 disk_usage, out uint64 num_dirs, out uint64 num_files)
+        throws Error
+    {
+        disk_usage = num_dirs = num_files = 0;
+        if (cancellable != null)
+            cancellable.set_error_if_cancelled();
+        if (!exists)
+            throw new IOError.NOT_FOUND("If you want to measure a mock file, " +
+                "create it with its exists property set to true.");
+
+        if ((flags & FileMeasureFlags.APPARENT_SIZE) != 0)
+            disk_usage = subtree_usage.apparent_bytes;
+        else
+            disk_usage = subtree_usage.allocated_bytes;
+        num_dirs = subtree_usage.dirs;
+        num_files = subtree_usage.files;
+
+        if (progress_callback != null)
+            progress_callback(true, disk_usage, num_dirs, num_files);
+        return true;
+    }
+
+    public async bool measure_disk_usage_async(FileMeasureFlags flags,
+        int io_priority, Cancellable? cancellable,
+        FileMeasureProgressCallback? progress_callback,
+        out uint64 disk_usage, out uint64 num_dirs, out uint64 num_files)
+        throws Error
+    {
+        // Report the result from the main loop, like a real async operation
+        report_later(0, io_priority, measure_disk_usage_async.callback);
+        yield;
+        return measure_disk_usage(flags, cancellable, progress_callback,
+            out disk_usage, out num_dirs, out num_files);
+    }
+
+    // Calls @callback from the main loop after @delay microseconds, to report
+    // the result of an async operation on a mock file or stream. Like GTask,
+    // it uses the thread-default main context of the thread that started the
+    // operation, which isn't the global default one in a worker thread.
+    internal static void report_later(int64 delay, int priority,
+        owned SourceFunc callback)
+    {
+        Source source;
+        if (delay > 0)
+            source = new TimeoutSource((uint) ((delay + 999) / 1000));
+        else
+            source = new IdleSource();
+        source.set_priority(priority);
+        source.set_callback((owned) callback);
+        source.attach(MainContext.ref_thread_default());
+    }
+
     /* TODO */
-    // public override measure_disk_usage();
     // public override enumerate_children_async();
     // public override query_info_async();
     // public override query_filesystem_info_async();
@@ -532,7 +967,6 @@ public class MockFile : Object, File {
     // public override open_readwrite_async();
     // public override create_readwrite_async();
     // public override replace_readwrite_async();
-    // public override measure_disk_usage_async();
 
     // FIXME: what does setting this flag claim that this implementation supports?
     // FIXME: no way to override the bool field in the class structure in Vala?
@@ -550,7 +984,29 @@ public class MockFile : Object, File {
      * that something has been written to the file, without going through the
      * I/O API.
      */
-    public Bytes contents { set; get; default = new Bytes(new uint8[0]); }
+    public Bytes contents {
+        get {
+            sync_from_arena();
+            return _contents;
+        }
+        set {
+            store_contents(value);
+            try_publish_to_arena();
+        }
+    }
+
+    // @etag, if given, was already computed for @value; it is set before
+    // anyone is told about the change
+    private void store_contents(Bytes value, string? etag = null) {
+        _contents = value;
+        cached_etag = etag;
+        invalidate_info();
+        nul_terminated_contents = null;
+        utf8_valid = -1;
+        modification_time = get_real_time();
+        update_usage();
+        poll_state_changed();
+    }
 
     /**
      * Like #GtMockFile:contents, but this property takes a nul-terminated UTF-8
@@ -562,28 +1018,845 @@ public class MockFile : Object, File {
      * If you don't know whether the file contains a UTF-8 string, then you
      * might want to use #GtMockFile:contents instead.
      *
-     * This method makes a copy of the contents of the file, so if you expect
-     * the file to be huge, use #GtMockFile:contents instead.
+     * The returned string is owned by the mock file and stays valid until the
+     * contents change.
+     * Contents set through this property are stored with a terminating nul
+     * byte, so getting them back doesn't copy anything.
+     * Otherwise, the contents are copied once, the first time this property
+     * is read after they change.
      */
     public string contents_utf8 {
         get {
+            sync_from_arena();
             // get_data() can return null if length == 0
-            if (contents.length == 0)
+            if (_contents.length == 0)
                 return "";
 
             // (string) Bytes.get_data() doesn't add a null byte at the end!
-            var bytes = new ByteArray();
-            bytes.data = contents.get_data();
-            bytes.append({0});
-            return (string) bytes.data;
+            if (nul_terminated_contents == null) {
+                var buffer = new uint8[_contents.length + 1];
+                Memory.copy(buffer, _contents.get_data(), _contents.length);
+                buffer[_contents.length] = 0;
+                nul_terminated_contents = new Bytes.take((owned) buffer);
+            }
+            return (string) nul_terminated_contents.get_data();
+        }
+        set {
+            // Keep the nul byte just past the end of the contents
+            var buffer = new uint8[value.length + 1];
+            Memory.copy(buffer, value, value.length + 1);
+            var storage = new Bytes.take((owned) buffer);
+            contents = new Bytes.from_bytes(storage, 0, value.length);
+            nul_terminated_contents = storage;
+        }
+    }
+
+    /**
+     * Whether the contents of the mock file are valid UTF-8.
+     * This is checked at most once for each change to the contents.
+     */
+    public bool contents_valid_utf8 {
+        get {
+            sync_from_arena();
+            if (utf8_valid == -1) {
+                var valid = _contents.length == 0 ||
+                    ((string) _contents.get_data()).validate(_contents.length);
+                utf8_valid = valid ? 1 : 0;
+            }
+            return utf8_valid == 1;
+        }
+    }
+
+    /**
+     * Entity tag of the current contents of the mock file.
+     *
+     * The etag is derived from a hash of the contents.
+     * It is computed at most once for each change to the contents, and when
+     * the contents are written through a stream it is computed incrementally
+     * as the data is written.
+     */
+    public string etag {
+        get {
+            if (cached_etag == null)
+                cached_etag = ContentHash.compute_etag(_contents);
+            return cached_etag;
+        }
+    }
+
+    // Sets the contents along with an etag that was already computed for them
+    // Throws if the new contents could not be stored in the mock arena; they
+    // are still set in this process
+    internal void set_contents_with_etag(Bytes contents, string? etag)
+        throws IOError
+    {
+        store_contents(contents, etag);
+        notify_property("contents");
+        publish_to_arena();
+    }
+
+    /**
+     * Limits the number of bytes that each read on a stream opened with
+     * g_file_read() transfers, or null to transfer as many as requested.
+     * Only streams opened after setting this property are affected.
+     */
+    public ChunkPolicy? read_chunk_policy { get; set; }
+
+    /**
+     * Limits the number of bytes that each write on a stream opened with
+     * g_file_create() transfers, or null to transfer as many as requested.
+     * Only streams opened after setting this property are affected.
+     */
+    public ChunkPolicy? write_chunk_policy { get; set; }
+
+    /**
+     * Number of times g_input_stream_read() has been called on streams opened
+     * on this file.
+     */
+    public uint n_read_calls {
+        get {
+            io_counters_mutex.lock();
+            var retval = _n_read_calls;
+            io_counters_mutex.unlock();
+            return retval;
+        }
+    }
+
+    /**
+     * Number of times g_output_stream_write() has been called on streams
+     * opened on this file.
+     */
+    public uint n_write_calls {
+        get {
+            io_counters_mutex.lock();
+            var retval = _n_write_calls;
+            io_counters_mutex.unlock();
+            return retval;
+        }
+    }
+
+    /**
+     * Total number of bytes read from streams opened on this file.
+     */
+    public uint64 n_bytes_read {
+        get {
+            io_counters_mutex.lock();
+            var retval = _n_bytes_read;
+            io_counters_mutex.unlock();
+            return retval;
+        }
+    }
+
+    /**
+     * Total number of bytes written to streams opened on this file.
+     */
+    public uint64 n_bytes_written {
+        get {
+            io_counters_mutex.lock();
+            var retval = _n_bytes_written;
+            io_counters_mutex.unlock();
+            return retval;
+        }
+    }
+
+    /**
+     * Sets #GtMockFile:n-read-calls, #GtMockFile:n-write-calls,
+     * #GtMockFile:n-bytes-read, and #GtMockFile:n-bytes-written back to zero.
+     */
+    public void reset_io_counters() {
+        io_counters_mutex.lock();
+        _n_read_calls = _n_write_calls = 0;
+        _n_bytes_read = _n_bytes_written = 0;
+        io_counters_mutex.unlock();
+    }
+
+    // Emitted when something happens that can make a stream on this file
+    // readable, such as the contents changing or a writer closing
+    internal signal void poll_state_changed();
+
+    // Number of output streams open on this file; while there are any, a
+    // pollable reader that reaches the end of the contents waits for more
+    internal uint n_open_writers { get { return AtomicUint.get(ref _n_open_writers); } }
+
+    internal void writer_opened() {
+        AtomicUint.inc(ref _n_open_writers);
+    }
+
+    internal void writer_closed() {
+        if (AtomicUint.dec_and_test(ref _n_open_writers))
+            poll_state_changed();
+    }
+
+    internal void reader_opened() {
+        AtomicUint.inc(ref _n_open_readers);
+    }
+
+    internal void reader_closed() {
+        AtomicUint.dec_and_test(ref _n_open_readers);
+    }
+
+    internal void adjust_buffered_bytes(int64 delta) {
+        buffered_bytes += delta;
+    }
+
+    /**
+     * Reports how much memory this mock file and its descendants use.
+     *
+     * The report is a dictionary (a{sv}) with the following keys:
+     *  - `n-files` (t): number of mock files
+     *  - `metadata-bytes` (t): estimated memory used by the mock files
+     *    themselves, not counting their contents
+     *  - `logical-bytes` (t): total size of the contents of all the files
+     *  - `resident-bytes` (t): memory actually used by the contents; contents
+     *    shared between files, for example by setting the same #GBytes on
+     *    several files, only count once
+     *  - `n-open-streams` (t): number of streams open on the files
+     *  - `buffered-bytes` (t): data written to output streams that haven't
+     *    been closed yet
+     *  - `largest-files` (a(st)): paths and sizes of the largest files,
+     *    largest first
+     *  - `largest-subtrees` (a(st)): paths and total sizes of the directories
+     *    with the largest contents, largest first
+     *
+     * Paths are relative to the root of the mock tree, as in fault injection
+     * patterns.
+     *
+     * @param n_largest How many files and subtrees to list
+     * @return (transfer floating): the report
+     */
+    public Variant get_memory_report(uint n_largest = 5) {
+        var report = new MemoryReport(n_largest);
+        add_to_memory_report(report);
+        return report.to_variant();
+    }
+
+    private void add_to_memory_report(MemoryReport report) {
+        sync_from_arena();
+        var path = get_mock_path();
+        TypeQuery query;
+        typeof(MockFile).query(out query);
+        var metadata_size = query.instance_size + id.length + 1 +
+            (basename != null ? basename.length + 1 : 0) +
+            children.length() * 3 * sizeof(void *);
+        report.add_file(path, metadata_size, _contents,
+            AtomicUint.get(ref _n_open_readers) + n_open_writers,
+            buffered_bytes);
+        if (is_directory())
+            report.add_subtree(path, subtree_usage.apparent_bytes);
+        foreach (var child in children)
+            child.add_to_memory_report(report);
+    }
+
+    /**
+     * Prints the report from gt_mock_file_get_memory_report() with
+     * g_test_message(), so that it shows up as a comment in the TAP output of
+     * the test.
+     * Call this from your teardown function to keep an eye on how much memory
+     * each test uses.
+     *
+     * @param n_largest How many files and subtrees to list
+     */
+    public void print_memory_report(uint n_largest = 5) {
+        var report = new VariantDict(get_memory_report(n_largest));
+        uint64 n_files = 0, metadata_bytes = 0, logical_bytes = 0,
+            resident_bytes = 0, n_open_streams = 0, buffered = 0;
+        report.lookup("n-files", "t", out n_files);
+        report.lookup("metadata-bytes", "t", out metadata_bytes);
+        report.lookup("logical-bytes", "t", out logical_bytes);
+        report.lookup("resident-bytes", "t", out resident_bytes);
+        report.lookup("n-open-streams", "t", out n_open_streams);
+        report.lookup("buffered-bytes", "t", out buffered);
+        Test.message("mock tree %s: %" + uint64.FORMAT + " files, %" +
+            uint64.FORMAT + " bytes of metadata, %" + uint64.FORMAT +
+            " bytes of contents (%" + uint64.FORMAT + " resident), %" +
+            uint64.FORMAT + " open streams, %" + uint64.FORMAT +
+            " bytes buffered", get_mock_path(), n_files, metadata_bytes,
+            logical_bytes, resident_bytes, n_open_streams, buffered);
+        foreach (var key in new string[] { "largest-files", "largest-subtrees" }) {
+            var list = report.lookup_value(key, new VariantType("a(st)"));
+            foreach (var entry in list) {
+                string path;
+                uint64 size;
+                entry.get("(st)", out path, out size);
+                Test.message("  %s: %s, %" + uint64.FORMAT + " bytes", key,
+                    path, size);
+            }
+        }
+    }
+
+    internal void count_read(ssize_t nread) {
+        io_counters_mutex.lock();
+        _n_read_calls++;
+        _n_bytes_read += nread;
+        io_counters_mutex.unlock();
+    }
+
+    internal void count_write(ssize_t nwritten) {
+        io_counters_mutex.lock();
+        _n_write_calls++;
+        _n_bytes_written += nwritten;
+        io_counters_mutex.unlock();
+    }
+
+    /**
+     * Shared memory in which this file and its descendants are also kept, so
+     * that other processes can see them.
+     * A file is stored in the arena the next time it is created, written, or
+     * its contents are set.
+     *
+     * Descendants that don't have their own arena use the one of their nearest
+     * ancestor that does.
+     */
+    public MockArena? arena {
+        get { return _arena; }
+        set {
+            _arena = value;
+            AtomicInt.inc(ref arena_generation);
+        }
+    }
+
+    /**
+     * Where the contents of this file are kept.
+     *
+     * When this is %GT_MOCK_FILE_STORAGE_MEMFD, #GtMockFile:contents is a
+     * read-only mapping of the memfd, so getting it doesn't copy anything.
+     * Only streams opened after setting this property are affected.
+     */
+    public MockFileStorage storage { get; set; default = MockFileStorage.HEAP; }
+
+    /**
+     * What happens to data written to streams opened on this file.
+     * Only streams opened after setting this property are affected.
+     */
+    public MockWriteMode write_mode { get; set; default = MockWriteMode.STORE; }
+
+    internal ExpectedContents? expected_contents { get; private set; }
+
+    /**
+     * Offset of the first byte written in %GT_MOCK_WRITE_MODE_EXPECT that
+     * differed from the expected contents, or -1 if there was none.
+     * If the stream was closed before all the expected contents were written,
+     * this is the offset where the data stopped.
+     * Reset to -1 each time a stream is opened on the file.
+     */
+    public int64 expectation_mismatch_offset { get; internal set; default = -1; }
+
+    /**
+     * Number of bytes written by the last stream that was closed in
+     * %GT_MOCK_WRITE_MODE_DISCARD, %GT_MOCK_WRITE_MODE_DIGEST or
+     * %GT_MOCK_WRITE_MODE_EXPECT, since those modes don't keep the data.
+     * Unlike #GtMockFile:n-bytes-written, this is not cleared by
+     * gt_mock_file_reset_io_counters().
+     */
+    public uint64 written_length { get; internal set; default = 0; }
+
+    /**
+     * Running hash of the data written by the last stream that was closed in
+     * %GT_MOCK_WRITE_MODE_DIGEST, as a hexadecimal string, or null if no such
+     * stream was closed.
+     * It is also the file's etag until the contents change again.
+     */
+    public string? written_digest { get; internal set; default = null; }
+
+    /**
+     * Sets #GtMockFile:write-mode to %GT_MOCK_WRITE_MODE_EXPECT and makes
+     * streams subsequently opened on this file compare the data written to
+     * them with @expected.
+     *
+     * To compare against a large file on disk without reading it into memory,
+     * pass the bytes of a #GMappedFile.
+     *
+     * @param expected The expected contents
+     */
+    public void expect_contents(Bytes expected) {
+        expected_contents = new ExpectedContents.from_bytes(expected);
+        write_mode = MockWriteMode.EXPECT;
+    }
+
+    /**
+     * Like gt_mock_file_expect_contents(), but the expected contents are
+     * produced a chunk at a time by @generator as the data is written.
+     *
+     * @param length Total length of the expected contents
+     * @param generator Function that fills a buffer with the expected contents
+     */
+    public void expect_generated_contents(uint64 length,
+        owned MockContentGenerator generator)
+    {
+        expected_contents = new ExpectedContents.from_generator(length,
+            (owned) generator);
+        write_mode = MockWriteMode.EXPECT;
+    }
+
+    /**
+     * Fault injector that decides which operations on this file, the streams
+     * opened on it, and its descendants will fail.
+     *
+     * Descendants that don't have their own fault injector use the one of
+     * their nearest ancestor that does.
+     * If null and no ancestor has one, no faults are injected.
+     */
+    public FaultInjector? fault_injector { get; set; }
+
+    /* Content assertions */
+
+    /**
+     * Checks that the contents of the mock file are equal to @expected.
+     *
+     * If they are not, the current test is marked as failed with
+     * g_test_fail(), and the offset of the first differing byte is logged
+     * together with the bytes surrounding it in both buffers.
+     * The comparison is done in place, without copying either buffer.
+     *
+     * @param expected The expected contents
+     * @param mismatch_offset Return location for the offset of the first byte
+     * that differs, or -1 if the contents are equal
+     * @return true if the contents are equal, false otherwise.
+     */
+    public bool assert_contents_equal(Bytes expected, out int64 mismatch_offset) {
+        return compare_contents("gt_mock_file_assert_contents_equal",
+            (uint8 *) expected.get_data(), expected.get_size(),
+            out mismatch_offset);
+    }
+
+    /**
+     * Like gt_mock_file_assert_contents_equal(), but compares the contents
+     * with those of another mock file.
+     *
+     * @param other The mock file with the expected contents
+     * @param mismatch_offset Return location for the offset of the first byte
+     * that differs, or -1 if the contents are equal
+     * @return true if the contents are equal, false otherwise.
+     */
+    public bool assert_contents_equal_mock(MockFile other,
+        out int64 mismatch_offset)
+    {
+        var expected = other.contents;
+        return compare_contents("gt_mock_file_assert_contents_equal_mock",
+            (uint8 *) expected.get_data(), expected.get_size(),
+            out mismatch_offset);
+    }
+
+    /**
+     * Like gt_mock_file_assert_contents_equal(), but compares the contents
+     * with those of a golden file, usually one on disk.
+     *
+     * The golden file is streamed in fixed-size chunks, so it is never loaded
+     * into memory all at once.
+     *
+     * @param golden The file with the expected contents
+     * @param mismatch_offset Return location for the offset of the first byte
+     * that differs, or -1 if the contents are equal
+     * @param cancellable Optional #GCancellable
+     * @return true if the contents are equal, false otherwise.
+     * @throws Error if the golden file could not be read
+     */
+    public bool assert_contents_equal_file(File golden, out int64 mismatch_offset,
+        Cancellable? cancellable = null) throws Error
+    {
+        var stream = golden.read(cancellable);
+        try {
+            compare_with_stream(stream, out mismatch_offset, cancellable);
+        } catch (Error e) {
+            // Report the first error, not one from closing
+            try {
+                stream.close(null);
+            } catch (Error close_error) {
+            }
+            throw e;
         }
-        set { contents = new Bytes(value.data); }
+        stream.close(cancellable);
+        return mismatch_offset == -1;
+    }
+
+    private void compare_with_stream(InputStream stream,
+        out int64 mismatch_offset, Cancellable? cancellable) throws Error
+    {
+        mismatch_offset = -1;
+        var contents = this.contents;
+        var actual = (uint8 *) contents.get_data();
+        var actual_len = contents.get_size();
+        var buffer = new uint8[ContentCheck.CHUNK_SIZE];
+        size_t pos = 0;
+        size_t nread;
+        do {
+            stream.read_all(buffer, out nread, cancellable);
+            var overlap = size_t.min(nread, actual_len - pos);
+            var offset = ContentCheck.find_mismatch(actual + pos, buffer, overlap);
+            // One of the two may end before the other
+            if (offset == -1 && (overlap < nread ||
+                (nread < buffer.length && pos + nread < actual_len)))
+                offset = (int64) overlap;
+            if (offset != -1) {
+                mismatch_offset = (int64) pos + offset;
+                ContentCheck.report_mismatch("gt_mock_file_assert_contents_equal_file",
+                    mismatch_offset,
+                    ContentCheck.describe_window(actual, actual_len,
+                        (size_t) mismatch_offset),
+                    ContentCheck.describe_window(buffer, nread, (size_t) offset));
+                break;
+            }
+            pos += nread;
+        } while (nread == buffer.length);
+    }
+
+    private bool compare_contents(string what, uint8 *expected,
+        size_t expected_len, out int64 mismatch_offset)
+    {
+        var contents = this.contents;
+        var actual = (uint8 *) contents.get_data();
+        var actual_len = contents.get_size();
+        var overlap = size_t.min(actual_len, expected_len);
+        mismatch_offset = ContentCheck.find_mismatch(actual, expected, overlap);
+        if (mismatch_offset == -1 && actual_len != expected_len)
+            mismatch_offset = (int64) overlap;
+        if (mismatch_offset == -1)
+            return true;
+
+        ContentCheck.report_mismatch(what, mismatch_offset,
+            ContentCheck.describe_window(actual, actual_len, (size_t) mismatch_offset),
+            ContentCheck.describe_window(expected, expected_len,
+                (size_t) mismatch_offset));
+        return false;
+    }
+
+    /**
+     * Searches the contents of the mock file for @needle, without copying
+     * them.
+     *
+     * @param needle The bytes to look for
+     * @param start Offset at which to start searching
+     * @return the offset of the first occurrence of @needle at or after
+     * @start, or -1 if there is none.
+     */
+    public int64 find_in_contents(uint8[] needle, uint64 start = 0) {
+        var contents = this.contents;
+        return ContentCheck.find((uint8 *) contents.get_data(),
+            contents.get_size(), needle, (size_t) start);
+    }
+
+    /**
+     * Counts the non-overlapping occurrences of @needle in the contents of
+     * the mock file, without copying them.
+     *
+     * @param needle The bytes to look for; must not be empty
+     * @return the number of occurrences.
+     */
+    public uint64 count_in_contents(uint8[] needle) {
+        return_val_if_fail(needle.length > 0, 0);
+        uint64 retval = 0;
+        var contents = this.contents;
+        var data = (uint8 *) contents.get_data();
+        var len = contents.get_size();
+        int64 found;
+        size_t pos = 0;
+        while ((found = ContentCheck.find(data, len, needle, pos)) != -1) {
+            retval++;
+            pos = (size_t) found + needle.length;
+        }
+        return retval;
+    }
+
+    /**
+     * Checks that @regex matches somewhere in a range of the contents of the
+     * mock file.
+     *
+     * If it doesn't, the current test is marked as failed with g_test_fail()
+     * and the start of the range is logged.
+     * The range is matched in place, without copying it.
+     *
+     * @param regex The regular expression to match
+     * @param start Offset of the start of the range
+     * @param end Offset of the end of the range, or -1 for the end of the
+     * contents
+     * @return true if @regex matched, false otherwise.
+     */
+    public bool assert_contents_match(Regex regex, uint64 start = 0,
+        int64 end = -1)
+    {
+        var contents = this.contents;
+        var data = (uint8 *) contents.get_data();
+        var len = contents.get_size();
+        var range_end = end < 0 ? len : size_t.min((size_t) end, len);
+        var range_start = size_t.min((size_t) start, range_end);
+        // Empty contents have no data pointer, but must still match /^$/
+        unowned string subject = range_end > range_start ?
+            (string) (data + range_start) : "";
+        bool matched;
+        try {
+            matched = regex.match_full(subject,
+                (ssize_t) (range_end - range_start));
+        } catch (RegexError e) {
+            Test.message("gt_mock_file_assert_contents_match: %s", e.message);
+            matched = false;
+        }
+        if (!matched) {
+            Test.message("gt_mock_file_assert_contents_match: /%s/ does not " +
+                "match contents between offsets %" + size_t.FORMAT + " and %" +
+                size_t.FORMAT + "\n  starting with: %s", regex.get_pattern(),
+                range_start, range_end,
+                ContentCheck.describe_window(data + range_start,
+                    range_end - range_start, 0));
+            Test.fail();
+        }
+        return matched;
+    }
+
+    /**
+     * Creates or updates many descendants of this mock file at once.
+     *
+     * This does the same as getting each file with
+     * g_file_resolve_relative_path() and setting its contents with
+     * gt_mock_file_set_contents(), but also lets you say whether the file
+     * exists, and does it all in one call, which is much faster from language
+     * bindings.
+     * Parents of the files are created as needed.
+     * The paths must be relative and must not contain `..` components.
+     * The contents are not copied; they point into @files.
+     *
+     * @param files Dictionary (a{s(bay)}) of paths relative to this file, to
+     * whether the file exists and its contents
+     */
+    public void populate(Variant files)
+        requires(files.is_of_type(new VariantType("a{s(bay)}")))
+    {
+        foreach (var entry in files) {
+            string path;
+            bool exists;
+            Variant contents;
+            entry.get("{s(b@ay)}", out path, out exists, out contents);
+            populate_one(path, exists, contents.get_data_as_bytes());
+        }
+    }
+
+    /**
+     * Like gt_mock_file_populate(), but takes a hash table of paths to
+     * contents, and all of the files exist.
+     *
+     * @param files (element-type utf8 GBytes): Paths relative to this file,
+     * and the contents of the files
+     */
+    public void populate_from_table(HashTable<string, Bytes> files) {
+        files.foreach((path, contents) => populate_one(path, true, contents));
+    }
+
+    private void populate_one(string path, bool exists, Bytes contents)
+        requires(is_descendant_path(path))
+    {
+        var file = resolve_relative_path(path) as MockFile;
+        file.exists = exists;
+        file.contents = contents;
+    }
+
+    // Paths given to gt_mock_file_populate() must stay below this file
+    private static bool is_descendant_path(string path) {
+        if (Path.is_absolute(path))
+            return false;
+        foreach (var component in path.split("/")) {
+            if (component == "..")
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * Gets all the descendants of this mock file at once, in the format taken
+     * by gt_mock_file_populate().
+     * The contents are not copied.
+     * Descendants without a name, and anything below them, are left out.
+     *
+     * @return (transfer floating): Dictionary (a{s(bay)}) of paths relative
+     * to this file, to whether each file exists and its contents
+     */
+    public Variant export() {
+        var builder = new VariantBuilder(new VariantType("a{s(bay)}"));
+        foreach_descendant((path, file) => {
+            var contents = new Variant.from_bytes(VariantType.BYTESTRING,
+                file.contents, true);
+            builder.add("{s(b@ay)}", path, file.exists, contents);
+        });
+        return builder.end();
+    }
+
+    /**
+     * Like gt_mock_file_export(), but returns a hash table of paths to
+     * contents, only including the descendants that exist.
+     *
+     * @return (element-type utf8 GBytes) (transfer container): Paths relative
+     * to this file, and the contents of the files
+     */
+    public HashTable<string, Bytes> export_to_table() {
+        var table = new HashTable<string, Bytes>(str_hash, str_equal);
+        foreach_descendant((path, file) => {
+            if (file.exists)
+                table[path] = file.contents;
+        });
+        return table;
+    }
+
+    private delegate void DescendantFunc(string path, MockFile file);
+
+    // Children without a name, such as a former root that was given a parent
+    // by get_parent(), have no relative path, so they and their descendants
+    // are skipped.
+    private void foreach_descendant(DescendantFunc func, string? prefix = null) {
+        foreach (var child in children) {
+            if (child.basename == null)
+                continue;
+            var path = prefix == null ? child.basename :
+                prefix + Path.DIR_SEPARATOR_S + child.basename;
+            func(path, child);
+            child.foreach_descendant(func, path);
+        }
+    }
+
+    /**
+     * Writes this mock file and all of its descendants to @destination, so
+     * that they can be examined after the test process has exited.
+     *
+     * The dump holds the names, contents, existence, timestamps and I/O
+     * counters of the files.
+     * Files with identical contents share one copy of them in the dump, and
+     * the whole dump is written with a single vectored write.
+     * Load it again with gt_mock_file_load().
+     *
+     * @param destination File to write the dump to; it is replaced if it exists
+     * @param cancellable optional #GCancellable object
+     * @throws Error if the dump could not be written
+     */
+    public void dump(File destination, Cancellable? cancellable = null)
+        throws Error
+    {
+        var stream = destination.replace(null, false,
+            FileCreateFlags.REPLACE_DESTINATION, cancellable);
+        MockDump.write(this, stream, cancellable);
+        stream.close(cancellable);
+    }
+
+    /**
+     * Dumps this mock file and its descendants with gt_mock_file_dump(), but
+     * only if the current test has failed.
+     * Call this from your teardown function; it costs nothing for tests that
+     * pass.
+     *
+     * The location of the dump is reported with g_test_message().
+     * If the dump could not be written, that is reported too, but it doesn't
+     * cause any further failure.
+     *
+     * @param destination File to write the dump to
+     * @return whether the dump was written
+     */
+    public bool dump_if_failed(File destination) {
+        if (!Test.failed())
+            return false;
+        try {
+            dump(destination);
+        } catch (Error e) {
+            Test.message("Could not dump mock file %s: %s", get_mock_path(),
+                e.message);
+            return false;
+        }
+        Test.message("Dumped mock file %s to %s", get_mock_path(),
+            destination.get_parse_name());
+        return true;
+    }
+
+    /**
+     * Loads a tree of mock files that was written with gt_mock_file_dump().
+     *
+     * If @source is a local file, it is mapped into memory and the contents of
+     * the mock files point into the mapping, so loading a large dump is fast
+     * and contents are only paged in when they are used.
+     *
+     * @param source File to read the dump from
+     * @param cancellable optional #GCancellable object
+     * @return the root of the loaded tree
+     * @throws Error if the dump could not be read or is not valid
+     */
+    public static MockFile load(File source, Cancellable? cancellable = null)
+        throws Error
+    {
+        return MockDump.read(source, cancellable);
+    }
+
+    internal unowned List<MockFile> get_children() {
+        return children;
+    }
+
+    internal MockFileState get_state() {
+        sync_from_arena();
+        return MockFileState() {
+            id = this.id,
+            basename = this.basename,
+            exists = _exists,
+            contents = _contents,
+            creation_time = this.creation_time,
+            modification_time = this.modification_time,
+            n_read_calls = this.n_read_calls,
+            n_write_calls = this.n_write_calls,
+            n_bytes_read = this.n_bytes_read,
+            n_bytes_written = this.n_bytes_written
+        };
+    }
+
+    // Recreates a file from a dump, as the newest child of @parent if that is
+    // not null. The timestamps are restored as they were, so this doesn't go
+    // through the contents setter.
+    internal static MockFile restore(MockFile? parent, MockFileState state) {
+        var file = new MockFile.with_id(state.id);
+        file.basename = state.basename;
+        file._exists = state.exists;
+        file._contents = state.contents;
+        file.creation_time = state.creation_time;
+        file.modification_time = state.modification_time;
+        file._n_read_calls = state.n_read_calls;
+        file._n_write_calls = state.n_write_calls;
+        file._n_bytes_read = state.n_bytes_read;
+        file._n_bytes_written = state.n_bytes_written;
+        file.update_usage();
+        if (parent != null)
+            associate_parent_with_child(parent, file);
+        return file;
     }
 
     public bool exists {
-        get { return _exists; }
-        construct { _exists = value; }
+        get {
+            sync_from_arena();
+            return _exists;
+        }
+        set construct {
+            _exists = value;
+            invalidate_info();
+            update_usage();
+            poll_state_changed();
+            try_publish_to_arena();
+        }
         default = true;
     }
 }
+
+// Disk usage totals, as reported by g_file_measure_disk_usage()
+internal struct DiskUsage {
+    public int64 apparent_bytes;
+    public int64 allocated_bytes;
+    public int64 files;
+    public int64 dirs;
+
+    public DiskUsage add(DiskUsage other) {
+        return DiskUsage() {
+            apparent_bytes = apparent_bytes + other.apparent_bytes,
+            allocated_bytes = allocated_bytes + other.allocated_bytes,
+            files = files + other.files,
+            dirs = dirs + other.dirs
+        };
+    }
+
+    public DiskUsage subtract(DiskUsage other) {
+        return DiskUsage() {
+            apparent_bytes = apparent_bytes - other.apparent_bytes,
+            allocated_bytes = allocated_bytes - other.allocated_bytes,
+            files = files - other.files,
+            dirs = dirs - other.dirs
+        };
+    }
+}
 }  // namespace Gt
\ No newline at end of file
@@ -17,43 +17,249 @@
  */
 
 namespace Gt {
-internal class MockFileInputStream : FileInputStream {
+/**
+ * Input stream on a #GtMockFile
+ *
+ * This is what g_file_read() returns for a mock file.
+ * Besides the usual #GInputStream API, it can hand out the file's contents
+ * without copying them, for code that parses data in place, as it would over
+ * a mapped file: gt_mock_file_input_stream_read_bytes() returns slices of the
+ * contents rather than copies, and gt_mock_file_input_stream_peek() lets the
+ * caller look at the data ahead without consuming it.
+ *
+ * The stream implements #GPollableInputStream. It is readable while there is
+ * data left, while it is not held back by a throttled #GtMockMount, and at the
+ * end of the file when nobody is writing to the file.
+ * Data written through a stream on the mock file only becomes part of the
+ * file's contents when that stream is closed, as with g_file_replace() on a
+ * real file. So a reader that has reached the end of the contents while a
+ * writer is open stays unreadable until the writer closes, however much the
+ * writer has written so far.
+ */
+public class MockFileInputStream : FileInputStream, PollableInputStream {
     private MockFile file;
-    private InputStream memstream;
+    private Bytes snapshot;
+    // Seekable stream that the data is read from
+    private InputStream backing;
+    private ChunkCursor? chunks = null;
+    private int64 throttled_until = 0;  // monotonic time
+    private bool open = true;
 
-    public MockFileInputStream(MockFile file, InputStream memstream) {
+    internal MockFileInputStream(MockFile file, Bytes contents) {
+        this.with_backing(file, contents,
+            new MemoryInputStream.from_bytes(contents));
+    }
+
+    internal MockFileInputStream.with_backing(MockFile file, Bytes contents,
+        InputStream backing)
+    {
         this.file = file;
-        this.memstream = memstream;
+        snapshot = contents;
+        this.backing = backing;
+        if (file.read_chunk_policy != null)
+            chunks = new ChunkCursor(file.read_chunk_policy);
+        file.reader_opened();
     }
 
     public override ssize_t read([CCode(array_length_type = "gsize")] uint8[] buffer,
         Cancellable? cancellable = null) throws IOError
     {
-        return memstream.read(buffer, cancellable);
+        wait_for_throttling();
+        return read_now(buffer, cancellable);
+    }
+
+    private void wait_for_throttling() {
+        var now = get_monotonic_time();
+        if (throttled_until > now)
+            Thread.usleep((ulong) (throttled_until - now));
+    }
+
+    // Applies injected faults and the chunk policy to a read of @count bytes
+    private int limit(int count) {
+        if (file.inject_fault(MockOperation.STREAM_READ) == MockFault.SHORT_IO)
+            count = (count + 1) / 2;
+        if (chunks != null)
+            count = chunks.limit(count);
+        return count;
+    }
+
+    private void count_read(ssize_t nread) {
+        file.count_read(nread);
+        var mount = file.find_mount();
+        if (mount != null && nread > 0) {
+            var transfer_time = mount.get_transfer_time(nread);
+            if (transfer_time > 0)
+                throttled_until = get_monotonic_time() + transfer_time;
+        }
+    }
+
+    // Common start of reads and skips: a cancelled call must not use up an
+    // injected fault or a step of the chunk policy
+    private int begin_read(size_t count, Cancellable? cancellable)
+        throws IOError
+    {
+        if (cancellable != null)
+            cancellable.set_error_if_cancelled();
+        var limited = limit((int) size_t.min(count, int.MAX));
+        refresh();
+        return limited;
+    }
+
+    private ssize_t read_now(uint8[] buffer, Cancellable? cancellable)
+        throws IOError
+    {
+        var count = begin_read(buffer.length, cancellable);
+        var nread = backing.read(buffer[0:count], cancellable);
+        count_read(nread);
+        return nread;
+    }
+
+    // Reads by slicing the snapshot of the contents and moving the backing
+    // stream's position past the slice, so nothing is copied
+    private Bytes read_slice(size_t count, Cancellable? cancellable)
+        throws Error
+    {
+        count = begin_read(count, cancellable);
+        var size = snapshot.get_size();
+        var position = size_t.min((size_t) tell(), size);
+        count = size_t.min(count, size - position);
+        (backing as Seekable).seek((int64) count, SeekType.CUR, cancellable);
+        count_read((ssize_t) count);
+        return new Bytes.from_bytes(snapshot, position, count);
+    }
+
+    /**
+     * Reads up to @count bytes from the stream, like g_input_stream_read_bytes(),
+     * but without copying them: the returned #GBytes is a slice of the mock
+     * file's contents.
+     *
+     * Short reads, injected faults, chunk policies, and throttling apply as
+     * with g_input_stream_read().
+     *
+     * @param count Maximum number of bytes to read
+     * @param cancellable optional #GCancellable object
+     * @return the data read, or an empty #GBytes at end-of-file
+     * @throws Error as g_input_stream_read_bytes()
+     */
+    public new Bytes read_bytes(size_t count, Cancellable? cancellable = null)
+        throws Error
+    {
+        set_pending();
+        try {
+            wait_for_throttling();
+            return read_slice(count, cancellable);
+        } finally {
+            clear_pending();
+        }
     }
 
+    /**
+     * Asynchronous version of gt_mock_file_input_stream_read_bytes().
+     *
+     * @param count Maximum number of bytes to read
+     * @param io_priority the I/O priority of the request
+     * @param cancellable optional #GCancellable object
+     * @return the data read, or an empty #GBytes at end-of-file
+     * @throws Error as g_input_stream_read_bytes_async()
+     */
+    public new async Bytes read_bytes_async(size_t count,
+        int io_priority = Priority.DEFAULT, Cancellable? cancellable = null)
+        throws Error
+    {
+        set_pending();
+        try {
+            // Wait out any throttling, and report the result, from the main
+            // loop
+            MockFile.report_later(throttled_until - get_monotonic_time(),
+                io_priority, read_bytes_async.callback);
+            yield;
+            return read_slice(count, cancellable);
+        } finally {
+            clear_pending();
+        }
+    }
+
+    /**
+     * Gets the data that the next read would return, without consuming it,
+     * like g_buffered_input_stream_peek_buffer().
+     * Peeking doesn't count as a read call on the mock file.
+     *
+     * The data is borrowed from the mock file's contents. It stays valid until
+     * the stream is read from, seeked, or finalized.
+     *
+     * @return the rest of the contents from the current position
+     */
+    [CCode(array_length_type = "gsize")]
+    public unowned uint8[] peek() {
+        refresh();
+        unowned uint8[] data = snapshot.get_data();
+        var position = (int) int64.min(tell(), data.length);
+        return data[position:data.length];
+    }
+
+    // Like a real file, the stream sees data that is added to the file while
+    // it is open. Once it has read everything in its snapshot of the contents,
+    // it switches to the current contents if they are longer.
+    private void refresh() {
+        var contents = file.contents;
+        if (contents == snapshot || !(backing is MemoryInputStream))
+            return;
+        var position = tell();
+        if (position < snapshot.get_size() || contents.get_size() <= position)
+            return;
+        snapshot = contents;
+        backing = new MemoryInputStream.from_bytes(contents);
+        try {
+            (backing as Seekable).seek(position, SeekType.SET);
+        } catch (Error e) {
+            assert_not_reached();
+        }
+    }
+
+    // See ReadinessFunc. Writers only publish their data when they close, so
+    // at the end of the contents an open writer means waiting for the close.
+    private int64 get_readiness() {
+        if (throttled_until > get_monotonic_time())
+            return throttled_until;
+        refresh();
+        // At the end of the data, there's only more to come if someone is
+        // still writing; otherwise, reading returns end-of-file right away
+        if (tell() < snapshot.get_size() || file.n_open_writers == 0)
+            return 0;
+        return -1;
+    }
+
+    // Skipping counts as a read, and is subject to the same faults, chunk
+    // policy, and throttling
     public override ssize_t skip(size_t count, Cancellable? cancellable = null)
         throws IOError
     {
-        return memstream.skip(count, cancellable);
+        wait_for_throttling();
+        var nskipped = backing.skip(begin_read(count, cancellable), cancellable);
+        count_read(nskipped);
+        return nskipped;
     }
 
     public override bool close(Cancellable? cancellable = null) throws IOError {
-        return memstream.close(cancellable);
+        if (open) {
+            open = false;
+            file.reader_closed();
+        }
+        return backing.close(cancellable);
     }
 
     public override int64 tell() {
-        return (memstream as Seekable).tell();
+        return (backing as Seekable).tell();
     }
 
     public override bool can_seek() {
-        return (memstream as Seekable).can_seek();
+        return (backing as Seekable).can_seek();
     }
 
     public override bool seek(int64 offset, SeekType type,
         Cancellable? cancellable = null) throws Error
     {
-        return (memstream as Seekable).seek(offset, type, cancellable);
+        return (backing as Seekable).seek(offset, type, cancellable);
     }
 
     public override FileInfo query_info(string attributes,
@@ -65,5 +271,46 @@ internal class MockFileInputStream : FileInputStream {
     // public override async FileInfo query_info_async(string attributes,
     //    int io_priority = Priority.DEFAULT, Cancellable? cancellable = null)
     //    throws GLib.Error;
+
+    /* GPollableInputStream implementations */
+
+    public bool can_poll() {
+        return true;
+    }
+
+    public bool is_readable() {
+        return get_readiness() == 0;
+    }
+
+    public PollableSource create_source(Cancellable? cancellable = null) {
+        var ready_source = new ReadySource(file, get_readiness);
+        return new PollableSource.full(this, ready_source, cancellable);
+    }
+
+    public ssize_t read_nonblocking_fn([CCode(array_length_type = "gsize")] uint8[] buffer)
+        throws Error
+    {
+        if (!is_readable())
+            throw new IOError.WOULD_BLOCK("Mock file has no data available yet.");
+        return read_now(buffer, null);
+    }
+}
+
+// Input stream for mock files stored in a memfd, that code under test can get
+// the file descriptor of. It has its own file description, so reading from it
+// moves the stream's position, as with a real file.
+internal class MockFdInputStream : MockFileInputStream, FileDescriptorBased {
+    private MemfdInputStream memfd_stream;
+
+    public MockFdInputStream(MockFile file, Bytes contents,
+        MemfdInputStream memfd_stream)
+    {
+        base.with_backing(file, contents, memfd_stream);
+        this.memfd_stream = memfd_stream;
+    }
+
+    public int get_fd() {
+        return memfd_stream.fd;
+    }
 }
 }  // namespace Gt
@@ -17,65 +17,353 @@
  */
 
 namespace Gt {
-internal class MockFileOutputStream : FileOutputStream {
-    private MockFile file;
-    private MemoryOutputStream memstream;
+internal class MockFileOutputStream : FileOutputStream, PollableOutputStream {
+    protected MockFile file;
+    // Seekable stream that holds the data until the stream is closed
+    private OutputStream backing;
+    private uint64 data_size = 0;
+    private ChunkCursor? chunks = null;
+    private uint64 charged = 0;  // bytes reserved on the mock mount, if any
+    // Hash of the data written so far; only valid as long as every write has
+    // appended to the end
+    private ContentHash hash = ContentHash();
+    private bool hash_valid = true;
+    private string? etag = null;
+    // In any mode other than STORE, nothing is written to backing, and the
+    // stream keeps track of its own position
+    private MockWriteMode mode;
+    private uint64 position = 0;
+    private ExpectedContents? expected = null;
+    private uint8[]? scratch = null;
+    private int64 throttled_until = 0;  // monotonic time
+    private bool open = true;
 
-    public MockFileOutputStream(MockFile file, MemoryOutputStream memstream) {
+    public MockFileOutputStream(MockFile file, OutputStream backing) {
         this.file = file;
-        this.memstream = memstream;
+        this.backing = backing;
+        if (file.write_chunk_policy != null)
+            chunks = new ChunkCursor(file.write_chunk_policy);
+        mode = file.write_mode;
+        if (mode == MockWriteMode.EXPECT) {
+            expected = file.expected_contents;
+            file.expectation_mismatch_offset = -1;
+        }
+        file.writer_opened();
     }
 
     public override ssize_t write([CCode(array_length_type = "gsize")] uint8[] buffer,
         Cancellable? cancellable = null) throws IOError
     {
-        return memstream.write(buffer, cancellable);
+        return write_throttled(buffer, cancellable);
+    }
+
+    // Called from writev() and writev_async() as well, which can't go through
+    // g_output_stream_write() since the stream already has a pending operation
+    private ssize_t write_throttled(uint8[] buffer, Cancellable? cancellable)
+        throws IOError
+    {
+        var now = get_monotonic_time();
+        if (throttled_until > now)
+            Thread.usleep((ulong) (throttled_until - now));
+        var nwritten = write_now(buffer, cancellable);
+
+        var mount = file.find_mount();
+        if (mount != null && nwritten > 0) {
+            var transfer_time = mount.get_transfer_time(nwritten);
+            if (transfer_time > 0)
+                throttled_until = get_monotonic_time() + transfer_time;
+        }
+        return nwritten;
+    }
+
+    // A vectored write counts as one write call, like writev() would, and
+    // costs at most one reallocation of the stored data, since the vectors are
+    // first gathered into one temporary block. Vectors are plain pointers that
+    // the caller may reuse as soon as this returns, so they can't be kept by
+    // reference.
+    public override bool writev([CCode(array_length_type = "gsize")] OutputVector[] vectors,
+        out size_t bytes_written, Cancellable? cancellable = null) throws Error
+    {
+        bytes_written = writev_now(vectors, cancellable);
+        return true;
+    }
+
+    public override async bool writev_async(
+        [CCode(array_length_type = "gsize")] OutputVector[] vectors,
+        int io_priority, Cancellable? cancellable, out size_t bytes_written)
+        throws Error
+    {
+        // Wait out any throttling, and report the result, from the main loop
+        MockFile.report_later(throttled_until - get_monotonic_time(),
+            io_priority, writev_async.callback);
+        yield;
+        bytes_written = writev_now(vectors, cancellable);
+        return true;
+    }
+
+    private size_t writev_now(OutputVector[] vectors, Cancellable? cancellable)
+        throws IOError
+    {
+        size_t count = 0;
+        foreach (unowned OutputVector vector in vectors)
+            count = size_t.min(count + vector.size, int.MAX);
+        if (count == 0)
+            return 0;
+        if (vectors.length == 1)
+            return write_throttled(vector_data(vectors[0], count), cancellable);
+
+        var gathered = new uint8[count];
+        size_t offset = 0;
+        foreach (unowned OutputVector vector in vectors) {
+            var length = size_t.min(vector.size, count - offset);
+            Memory.copy((uint8 *) gathered + offset, vector.buffer, length);
+            offset += length;
+            if (offset == count)
+                break;
+        }
+        return write_throttled(gathered[0:count], cancellable);
+    }
+
+    private static unowned uint8[] vector_data(OutputVector vector, size_t max) {
+        unowned uint8[] retval = (uint8[]) vector.buffer;
+        retval.length = (int) size_t.min(vector.size, max);
+        return retval;
+    }
+
+    private ssize_t write_now(uint8[] buffer, Cancellable? cancellable)
+        throws IOError
+    {
+        var count = buffer.length;
+        if (file.inject_fault(MockOperation.STREAM_WRITE) == MockFault.SHORT_IO)
+            count = (count + 1) / 2;
+        if (chunks != null)
+            count = chunks.limit(count);
+        if (mode != MockWriteMode.STORE)
+            return write_without_storing(buffer[0:count]);
+
+        var mount = file.find_mount();
+        if (mount != null)
+            count = reserve_space(mount, count);
+
+        var appending = tell() == data_size;
+        var nwritten = backing.write(buffer[0:count], cancellable);
+        file.count_write(nwritten);
+        if (appending)
+            hash.update(buffer[0:(int) nwritten]);
+        else
+            hash_valid = false;
+        set_data_size(uint64.max(data_size, tell()));
+        return nwritten;
+    }
+
+    private ssize_t write_without_storing(uint8[] buffer) throws IOError {
+        if (expected != null) {
+            var offset = expected.compare(buffer, position, ref scratch);
+            if (offset != -1) {
+                file.expectation_mismatch_offset = (int64) position + offset;
+                throw new IOError.INVALID_DATA("Data written to mock file " +
+                    "differs from the expected contents at offset %" +
+                    int64.FORMAT + ".", file.expectation_mismatch_offset);
+            }
+        }
+        if (mode == MockWriteMode.DIGEST)
+            hash.update(buffer);
+        position += buffer.length;
+        file.count_write(buffer.length);
+        return buffer.length;
+    }
+
+    // Keeps the mock file's count of buffered data up to date
+    private void set_data_size(uint64 size) {
+        file.adjust_buffered_bytes((int64) size - (int64) data_size);
+        data_size = size;
+    }
+
+    // Charges the mount for the space that a write of @count bytes needs, and
+    // cuts @count short so that the write ends exactly where the mount fills
+    // up, or throws if the mount is already full
+    private int reserve_space(MockMount mount, int count) throws IOError {
+        if (mount.read_only)
+            throw new IOError.READ_ONLY("This mock file is on a read-only mock mount.");
+        var end = (uint64) tell() + count;
+        if (count == 0 || end <= charged)
+            return count;
+        var growth = end - charged;
+        var granted = mount.try_reserve(growth);
+        charged += granted;
+        var shortfall = growth - granted;
+        if (shortfall == 0)
+            return count;
+        if (shortfall >= count) {
+            // None of the data fits, so the space before it isn't needed yet
+            mount.adjust_used(-(int64) granted);
+            charged -= granted;
+            throw new IOError.NO_SPACE("No space left on mock mount.");
+        }
+        return count - (int) shortfall;
     }
 
     public override bool close(Cancellable? cancellable = null) throws IOError {
-        var retval = memstream.close(cancellable);
-        var data_written = memstream.steal_as_bytes();
-        file.contents = data_written;
+        // Readers waiting for more data must see the new contents when they
+        // are woken up. The stream counts as closed even if closing fails.
+        try {
+            return close_and_store(cancellable);
+        } finally {
+            // If storing failed, the contents are unchanged, and the space
+            // reserved for the new contents must not stay charged
+            release_reservation();
+            if (open) {
+                open = false;
+                set_data_size(0);
+                file.writer_closed();
+            }
+        }
+    }
+
+    // Gives back the space reserved on the mock mount while writing
+    private void release_reservation() {
+        if (charged == 0)
+            return;
+        var mount = file.find_mount();
+        if (mount != null)
+            mount.adjust_used(-(int64) charged);
+        charged = 0;
+    }
+
+    private bool close_and_store(Cancellable? cancellable) throws IOError {
+        file.inject_fault(MockOperation.STREAM_CLOSE);
+        var retval = backing.close(cancellable);
+        var data_written = take_written_data();
+        if (mode != MockWriteMode.STORE) {
+            if (expected != null && position < expected.length) {
+                // Don't overwrite the offset of an earlier failed write
+                if (file.expectation_mismatch_offset == -1)
+                    file.expectation_mismatch_offset = (int64) position;
+                throw new IOError.INVALID_DATA("Only %" + uint64.FORMAT +
+                    " of the %" + uint64.FORMAT + " expected bytes were " +
+                    "written to mock file.", position, expected.length);
+            }
+            var digest = mode == MockWriteMode.DIGEST ? hash.to_etag() : null;
+            file.written_length = position;
+            if (digest != null)
+                file.written_digest = digest;
+            file.set_contents_with_etag(data_written, digest);
+            etag = file.etag;
+            return retval;
+        }
+        // Setting the contents charges the final size
+        release_reservation();
+        file.set_contents_with_etag(data_written, hash_valid ? hash.to_etag() : null);
+        etag = file.etag;
         return retval;
     }
 
+    // Returns the data that was written, after the backing stream is closed
+    protected virtual Bytes take_written_data() throws IOError {
+        return ((MemoryOutputStream) backing).steal_as_bytes();
+    }
+
     public override FileInfo query_info(string attributes,
         Cancellable? cancellable = null) throws Error
     {
         return file.query_info(attributes, FileQueryInfoFlags.NONE, cancellable);
     }
 
+    // Only valid after the stream is closed
     public override string get_etag() {
-        // FIXME: etags are blank for now
-        return "";
+        return etag ?? "";
     }
 
     public override int64 tell() {
-        return (memstream as Seekable).tell();
+        if (mode != MockWriteMode.STORE)
+            return (int64) position;
+        return (backing as Seekable).tell();
     }
 
     public override bool can_seek() {
-        return (memstream as Seekable).can_seek();
+        return mode == MockWriteMode.STORE && (backing as Seekable).can_seek();
     }
 
     public override bool seek(int64 offset, SeekType type,
         Cancellable? cancellable = null) throws Error
     {
-        return (memstream as Seekable).seek(offset, type, cancellable);
+        if (mode != MockWriteMode.STORE)
+            throw new IOError.NOT_SUPPORTED("Streams on mock files that don't " +
+                "store their data can't seek.");
+        return (backing as Seekable).seek(offset, type, cancellable);
     }
 
     public override bool can_truncate () {
-        return (memstream as Seekable).can_truncate();
+        return mode == MockWriteMode.STORE &&
+            (backing as Seekable).can_truncate();
     }
 
     public override bool truncate_fn(int64 size,
         Cancellable? cancellable = null) throws Error
     {
-        return (memstream as Seekable).truncate(size, cancellable);
+        if (mode != MockWriteMode.STORE)
+            throw new IOError.NOT_SUPPORTED("Streams on mock files that don't " +
+                "store their data can't truncate.");
+        if (size != data_size)
+            hash_valid = false;
+        var retval = (backing as Seekable).truncate(size, cancellable);
+        set_data_size(size);
+        return retval;
+    }
+
+    /* GPollableOutputStream implementations */
+
+    public bool can_poll() {
+        return true;
+    }
+
+    public bool is_writable() {
+        return get_readiness() == 0;
+    }
+
+    // See ReadinessFunc; mock files can always take more data, unless the
+    // stream is being throttled
+    private int64 get_readiness() {
+        return throttled_until > get_monotonic_time() ? throttled_until : 0;
+    }
+
+    public PollableSource create_source(Cancellable? cancellable = null) {
+        var ready_source = new ReadySource(file, get_readiness);
+        return new PollableSource.full(this, ready_source, cancellable);
+    }
+
+    public ssize_t write_nonblocking_fn([CCode(array_length_type = "gsize")] uint8[] buffer)
+        throws Error
+    {
+        if (!is_writable())
+            throw new IOError.WOULD_BLOCK("Mock mount is busy.");
+        return write(buffer, null);
     }
 
     // public override async FileInfo query_info_async(string attributes,
     //    int io_priority = Priority.DEFAULT, Cancellable? cancellable = null)
     //    throws Error;
 }
+
+// Output stream for mock files stored in a memfd, that code under test can
+// get the file descriptor of. When it is closed, its memfd becomes the
+// storage of the mock file's new contents.
+internal class MockFdOutputStream : MockFileOutputStream, FileDescriptorBased {
+    private MemfdOutputStream memfd_stream;
+
+    public MockFdOutputStream(MockFile file, MemfdOutputStream memfd_stream) {
+        base(file, memfd_stream);
+        this.memfd_stream = memfd_stream;
+    }
+
+    public int get_fd() {
+        return memfd_stream.fd;
+    }
+
+    protected override Bytes take_written_data() throws IOError {
+        var retval = Memfd.map(memfd_stream.fd);
+        file.adopt_memfd(memfd_stream.steal_fd(), retval);
+        return retval;
+    }
+}
 }  // namespace Gt
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2026 The Gt authors
+ *
+ * This file is part of Gt.
+ *
+ * Gt is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * Gt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Gt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gt {
+/**
+ * Owner of a whole tree of mock files
+ *
+ * Each #GtMockFile holds a reference to its parent and to each of its
+ * children, so a tree of mock files keeps itself alive, and is never freed
+ * just by unreferencing the files that a test created.
+ * A mock filesystem keeps track of every file in the tree below its root,
+ * including ones created implicitly with g_file_get_child(),
+ * g_file_resolve_relative_path() or g_file_get_parent().
+ * Clearing or finalizing it frees the whole tree at once, in one pass over a
+ * flat list of files, instead of walking the tree.
+ *
+ * Create one in your test fixture's setup function and unreference it in
+ * the teardown function.
+ *
+ * Files that a test still holds references to after the filesystem is
+ * cleared stay valid, but they are cut off from their parents and children.
+ *
+ * The filesystem only takes care of ownership. Every file in the tree is
+ * still a separate #GtMockFile, allocated when it is first looked up and freed
+ * when the filesystem is cleared, so clearing takes time in proportion to the
+ * number of files. The files are not pooled between tests. A test may keep a
+ * file, its signal handlers or weak pointers to it beyond the teardown, so
+ * reusing a file would change a file that the test can still see.
+ */
+public class MockFilesystem : Object {
+    private GenericArray<MockFile> files = new GenericArray<MockFile>();
+
+    /**
+     * The root of the tree of mock files that this filesystem owns.
+     */
+    public MockFile root { get; private set; }
+
+    /**
+     * Number of mock files in the tree, including the root.
+     */
+    public uint n_files { get { return files.length; } }
+
+    /**
+     * Creates a new mock filesystem with an empty root directory.
+     *
+     * @return the new #GtMockFilesystem
+     */
+    public MockFilesystem() {}
+
+    construct {
+        add_root();
+    }
+
+    ~MockFilesystem() {
+        release_files();
+    }
+
+    private void add_root() {
+        root = new MockFile();
+        adopt(root);
+    }
+
+    // Called for every file that becomes part of the tree
+    internal void adopt(MockFile file) {
+        file.filesystem = this;
+        files.add(file);
+    }
+
+    /**
+     * Gets the mock file at @path relative to the root, creating it and any
+     * of its parents that don't exist yet.
+     *
+     * @param path Path relative to #GtMockFilesystem:root
+     * @return (transfer full): the mock file
+     */
+    public MockFile get_file(string path) {
+        return root.resolve_relative_path(path) as MockFile;
+    }
+
+    /**
+     * Frees all the mock files in the tree and starts again with a new, empty
+     * root, so that the filesystem can be used for the next test.
+     */
+    public void clear() {
+        release_files();
+        files = new GenericArray<MockFile>();
+        add_root();
+    }
+
+    // Cuts every file loose from its parent and children first, so that
+    // dropping the list finalizes each file on its own. The mounts are
+    // uncharged while the tree is still whole, since that needs each file's
+    // ancestors.
+    private void release_files() {
+        files.foreach((file) => file.leave_mount());
+        files.foreach((file) => {
+            file.filesystem = null;
+            file.detach_from_tree();
+        });
+    }
+}
+}  // namespace Gt
@@ -0,0 +1,326 @@
+/*
+ * Copyright 2026 The Gt authors
+ *
+ * This file is part of Gt.
+ *
+ * Gt is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * Gt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Gt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gt {
+/**
+ * Kinds of storage that a #GtMockMount can pretend to be.
+ *
+ * Each profile determines the mount's default filesystem type, whether it is
+ * remote, and its nominal latency and bandwidth.
+ */
+public enum MockStorageProfile {
+    /** In-memory filesystem: "tmpfs", no latency, unlimited bandwidth */
+    TMPFS,
+    /** Solid-state disk: "ext4", 0.1 ms latency, 500 MB/s */
+    SSD,
+    /** Rotating hard disk: "ext4", 10 ms latency, 100 MB/s */
+    SPINNING_DISK,
+    /** Network filesystem: "nfs", remote, 1 ms latency, 50 MB/s */
+    NFS;
+
+    internal unowned string get_filesystem_type() {
+        switch (this) {
+        case MockStorageProfile.SSD:
+        case MockStorageProfile.SPINNING_DISK:
+            return "ext4";
+        case MockStorageProfile.NFS:
+            return "nfs";
+        default:
+            return "tmpfs";
+        }
+    }
+
+    internal uint64 get_latency() {
+        switch (this) {
+        case MockStorageProfile.SSD:
+            return 100;
+        case MockStorageProfile.SPINNING_DISK:
+            return 10000;
+        case MockStorageProfile.NFS:
+            return 1000;
+        default:
+            return 0;
+        }
+    }
+
+    internal uint64 get_bandwidth() {
+        switch (this) {
+        case MockStorageProfile.SSD:
+            return 500000000;
+        case MockStorageProfile.SPINNING_DISK:
+            return 100000000;
+        case MockStorageProfile.NFS:
+            return 50000000;
+        default:
+            return 0;
+        }
+    }
+}
+
+/**
+ * Mock mount for tests
+ *
+ * Attach a mock mount to a #GtMockFile and that file and all of its
+ * descendants will report the mount from g_file_find_enclosing_mount(), and
+ * its capacity, usage, and filesystem type from g_file_query_filesystem_info().
+ *
+ * The mount keeps track of how many bytes its subtree uses as the contents of
+ * the files in it change.
+ * Writes to a stream on a file in the subtree that would exceed the mount's
+ * capacity are cut short at the exact byte where the mount fills up, and
+ * further writes fail with %G_IO_ERROR_NO_SPACE.
+ * If the mount is read-only, g_file_create() and g_file_replace() on files in
+ * its subtree fail with %G_IO_ERROR_READ_ONLY.
+ */
+public class MockMount : Object, Mount {
+    private WeakRef root_ref;
+    private Mutex mutex = Mutex();
+    private uint64 _used = 0;
+
+    /**
+     * Total number of bytes that the files on this mount can hold, or 0 for
+     * unlimited.
+     */
+    public uint64 capacity { get; set; default = 0; }
+
+    /**
+     * Number of bytes taken up by the contents of the files on this mount,
+     * including data written to streams that have not been closed yet.
+     */
+    public uint64 used {
+        get {
+            mutex.lock();
+            var retval = _used;
+            mutex.unlock();
+            return retval;
+        }
+    }
+
+    /**
+     * The kind of storage that this mount pretends to be.
+     */
+    public MockStorageProfile profile { get; construct; default = MockStorageProfile.TMPFS; }
+
+    /**
+     * Filesystem type reported in the `filesystem::type` attribute.
+     * Defaults to a value appropriate for #GtMockMount:profile.
+     */
+    public string filesystem_type { get; set; }
+
+    /**
+     * Whether the mount is read-only.
+     */
+    public bool read_only { get; set; default = false; }
+
+    /**
+     * Whether the mount is on a remote machine; true for
+     * %GT_MOCK_STORAGE_PROFILE_NFS.
+     */
+    public bool remote { get { return profile == MockStorageProfile.NFS; } }
+
+    /**
+     * Nominal time taken by each I/O operation on this mount, in microseconds,
+     * according to #GtMockMount:profile.
+     */
+    public uint64 latency { get { return profile.get_latency(); } }
+
+    /**
+     * Nominal number of bytes per second that can be transferred to or from
+     * this mount, according to #GtMockMount:profile, or 0 for unlimited.
+     */
+    public uint64 bandwidth { get { return profile.get_bandwidth(); } }
+
+    /**
+     * Whether streams on files on this mount are slowed down to
+     * #GtMockMount:latency and #GtMockMount:bandwidth.
+     *
+     * Blocking reads and writes sleep for as long as the transfer would take,
+     * and pollable streams don't become readable or writable again until
+     * that time has passed.
+     */
+    public bool throttle { get; set; default = false; }
+
+    /**
+     * Creates a new mock mount and attaches the subtree starting at @root to it.
+     * The usage of the mount starts out as the total size of the files already
+     * in the subtree.
+     *
+     * @param root The mock file at the root of the mount
+     * @param capacity Total number of bytes that the mount can hold, or 0 for
+     * unlimited
+     * @param profile The kind of storage to pretend to be
+     * @return the new #GtMockMount
+     */
+    public MockMount(MockFile root, uint64 capacity,
+        MockStorageProfile profile = MockStorageProfile.TMPFS)
+    {
+        Object(capacity: capacity, profile: profile);
+        root_ref = WeakRef(root);
+        _used = root.attach_mount(this);
+    }
+
+    construct {
+        filesystem_type = profile.get_filesystem_type();
+    }
+
+    // Charges up to @size more bytes to the mount, as many as fit, and returns
+    // how many were charged. Checking for space and charging it happen under
+    // one lock, so that writers on different threads can't both take the
+    // last free bytes.
+    internal uint64 try_reserve(uint64 size) {
+        mutex.lock();
+        var granted = size;
+        if (capacity != 0)
+            granted = uint64.min(size, capacity > _used ? capacity - _used : 0);
+        _used += granted;
+        mutex.unlock();
+        return granted;
+    }
+
+    internal void adjust_used(int64 delta) {
+        mutex.lock();
+        _used = (uint64) int64.max((int64) _used + delta, 0);
+        mutex.unlock();
+    }
+
+    // Returns how long a transfer of @nbytes takes in microseconds, if the
+    // mount is throttled
+    internal int64 get_transfer_time(size_t nbytes) {
+        if (!throttle)
+            return 0;
+        var retval = (int64) latency;
+        if (bandwidth != 0)
+            retval += (int64) (nbytes * 1000000.0 / bandwidth);
+        return retval;
+    }
+
+    internal void fill_filesystem_info(FileInfo info, FileAttributeMatcher matcher) {
+        // Free and used space come from one snapshot, so that they add up
+        mutex.lock();
+        var used = _used;
+        mutex.unlock();
+        var free = capacity == 0 ? uint64.MAX : capacity - uint64.min(used, capacity);
+        if (matcher.matches(FileAttribute.FILESYSTEM_SIZE))
+            info.set_attribute_uint64(FileAttribute.FILESYSTEM_SIZE, capacity);
+        if (matcher.matches(FileAttribute.FILESYSTEM_FREE))
+            info.set_attribute_uint64(FileAttribute.FILESYSTEM_FREE, free);
+        if (matcher.matches(FileAttribute.FILESYSTEM_USED))
+            info.set_attribute_uint64(FileAttribute.FILESYSTEM_USED, used);
+        if (matcher.matches(FileAttribute.FILESYSTEM_TYPE))
+            info.set_attribute_string(FileAttribute.FILESYSTEM_TYPE, filesystem_type);
+        if (matcher.matches(FileAttribute.FILESYSTEM_READONLY))
+            info.set_attribute_boolean(FileAttribute.FILESYSTEM_READONLY, read_only);
+        if (matcher.matches(FileAttribute.FILESYSTEM_REMOTE))
+            info.set_attribute_boolean(FileAttribute.FILESYSTEM_REMOTE, remote);
+    }
+
+    /* GMount implementations */
+
+    public File get_root() {
+        return root_ref.get() as File;
+    }
+
+    public string get_name() {
+        var root = get_root();
+        return root != null ? root.get_basename() : "Mock mount";
+    }
+
+    public Icon get_icon() {
+        return new ThemedIcon(remote ? "folder-remote" : "drive-harddisk");
+    }
+
+    public Icon get_symbolic_icon() {
+        return new ThemedIcon(remote ? "folder-remote-symbolic" : "drive-harddisk-symbolic");
+    }
+
+    public string? get_uuid() {
+        return null;
+    }
+
+    public Volume? get_volume() {
+        return null;
+    }
+
+    public Drive? get_drive() {
+        return null;
+    }
+
+    public File get_default_location() {
+        return get_root();
+    }
+
+    public unowned string? get_sort_key() {
+        return null;
+    }
+
+    public bool can_unmount() {
+        return false;
+    }
+
+    public bool can_eject() {
+        return false;
+    }
+
+    public async bool unmount(MountUnmountFlags flags,
+        Cancellable? cancellable = null) throws Error
+    {
+        throw new IOError.NOT_SUPPORTED("Mock mounts can't be unmounted.");
+    }
+
+    public async bool unmount_with_operation(MountUnmountFlags flags,
+        MountOperation? mount_operation, Cancellable? cancellable = null)
+        throws Error
+    {
+        throw new IOError.NOT_SUPPORTED("Mock mounts can't be unmounted.");
+    }
+
+    public async bool eject(MountUnmountFlags flags,
+        Cancellable? cancellable = null) throws Error
+    {
+        throw new IOError.NOT_SUPPORTED("Mock mounts can't be ejected.");
+    }
+
+    public async bool eject_with_operation(MountUnmountFlags flags,
+        MountOperation? mount_operation, Cancellable? cancellable = null)
+        throws Error
+    {
+        throw new IOError.NOT_SUPPORTED("Mock mounts can't be ejected.");
+    }
+
+    public async bool remount(MountMountFlags flags,
+        MountOperation? mount_operation, Cancellable? cancellable = null)
+        throws Error
+    {
+        if (cancellable != null)
+            cancellable.set_error_if_cancelled();
+        return true;
+    }
+
+    public async string[] guess_content_type(bool force_rescan,
+        Cancellable? cancellable = null) throws Error
+    {
+        return guess_content_type_sync(force_rescan, cancellable);
+    }
+
+    public string[] guess_content_type_sync(bool force_rescan,
+        Cancellable? cancellable = null) throws Error
+    {
+        return new string[0];
+    }
+}
+}  // namespace Gt
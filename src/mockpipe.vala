@@ -0,0 +1,395 @@
+/*
+ * Copyright 2026 The Gt authors
+ *
+ * This file is part of Gt.
+ *
+ * Gt is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * Gt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Gt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gt {
+// Bounded queue of bytes going one way through a mock pipe. Data is kept as a
+// queue of GBytes, so that it can be handed from the writer to the reader
+// without copying. It can be used from several threads; writers block while it
+// is full, and readers block while it is empty.
+internal class PipeBuffer : Object {
+    public size_t capacity { get; construct; }
+    private Queue<Bytes> chunks = new Queue<Bytes>();
+    private size_t head_offset = 0;  // bytes already read from the first chunk
+    private size_t n_buffered = 0;
+    private bool writer_closed = false;
+    private bool reader_closed = false;
+    private Mutex mutex = Mutex();
+    private Cond cond = Cond();
+
+    // Emitted, possibly from another thread, when the buffer may have become
+    // readable or writable. It is never emitted with the mutex held, since
+    // the handlers take the main context's lock.
+    internal signal void poll_state_changed();
+
+    public PipeBuffer(size_t capacity) {
+        Object(capacity: capacity);
+    }
+
+    // Waits while @blocked returns true. Must be called with the mutex held.
+    private void wait_while(Predicate blocked, Cancellable? cancellable)
+        throws IOError
+    {
+        ulong handler = 0;
+        if (cancellable != null) {
+            // Called right away if already cancelled, so don't hold the mutex
+            mutex.unlock();
+            handler = cancellable.connect(() => {
+                mutex.lock();
+                cond.broadcast();
+                mutex.unlock();
+            });
+            mutex.lock();
+        }
+        while (blocked() && (cancellable == null || !cancellable.is_cancelled()))
+            cond.wait(mutex);
+        if (handler != 0) {
+            mutex.unlock();
+            cancellable.disconnect(handler);
+            mutex.lock();
+        }
+        if (cancellable != null && cancellable.is_cancelled())
+            throw new IOError.CANCELLED("Operation was cancelled");
+    }
+
+    // Returns 0 if a write would go through without blocking, or -1 if it
+    // would block; see ReadinessFunc
+    public int64 get_write_readiness() {
+        mutex.lock();
+        var retval = n_buffered < capacity || reader_closed ? 0 : -1;
+        mutex.unlock();
+        return retval;
+    }
+
+    public int64 get_read_readiness() {
+        mutex.lock();
+        var retval = n_buffered > 0 || writer_closed ? 0 : -1;
+        mutex.unlock();
+        return retval;
+    }
+
+    // Adds as much of @data as fits, without copying it, and returns the
+    // number of bytes added. If the buffer is full, waits for space, unless
+    // not @blocking, in which case it throws WOULD_BLOCK.
+    public size_t push(Bytes data, bool blocking, Cancellable? cancellable)
+        throws IOError
+    {
+        var retval = push_locked(data, blocking, cancellable);
+        poll_state_changed();
+        return retval;
+    }
+
+    private size_t push_locked(Bytes data, bool blocking,
+        Cancellable? cancellable) throws IOError
+    {
+        mutex.lock();
+        try {
+            if (blocking)
+                wait_while(() => n_buffered >= capacity && !reader_closed, cancellable);
+            if (reader_closed)
+                throw new IOError.BROKEN_PIPE("The other end of the mock pipe was closed.");
+            if (writer_closed)
+                throw new IOError.CLOSED("Stream is already closed.");
+            if (n_buffered >= capacity)
+                throw new IOError.WOULD_BLOCK("Mock pipe is full.");
+            var count = size_t.min(data.get_size(), capacity - n_buffered);
+            if (count == 0)
+                return 0;
+            chunks.push_tail(count == data.get_size() ? data :
+                new Bytes.from_bytes(data, 0, count));
+            n_buffered += count;
+            cond.broadcast();
+            return count;
+        } finally {
+            mutex.unlock();
+        }
+    }
+
+    // Removes up to @max_count bytes from the buffer, without copying them if
+    // they are all in one chunk, or returns an empty GBytes at the end of the
+    // stream. If the buffer is empty, waits for data, unless not @blocking, in
+    // which case it throws WOULD_BLOCK.
+    public Bytes pop(size_t max_count, bool blocking, Cancellable? cancellable)
+        throws IOError
+    {
+        var retval = pop_locked(max_count, blocking, cancellable);
+        poll_state_changed();
+        return retval;
+    }
+
+    private Bytes pop_locked(size_t max_count, bool blocking,
+        Cancellable? cancellable) throws IOError
+    {
+        mutex.lock();
+        try {
+            if (blocking)
+                wait_while(() => n_buffered == 0 && !writer_closed, cancellable);
+            if (reader_closed)
+                throw new IOError.CLOSED("Stream is already closed.");
+            if (n_buffered == 0 && !writer_closed)
+                throw new IOError.WOULD_BLOCK("Mock pipe is empty.");
+            if (n_buffered == 0 || max_count == 0)
+                return new Bytes(null);
+
+            var head = chunks.peek_head();
+            var available = head.get_size() - head_offset;
+            var count = size_t.min(max_count, available);
+            Bytes retval;
+            if (head_offset == 0 && count == head.get_size())
+                retval = head;
+            else
+                retval = new Bytes.from_bytes(head, head_offset, count);
+            head_offset += count;
+            if (head_offset == head.get_size()) {
+                chunks.pop_head();
+                head_offset = 0;
+            }
+            n_buffered -= count;
+            cond.broadcast();
+            return retval;
+        } finally {
+            mutex.unlock();
+        }
+    }
+
+    public void close_writer() {
+        mutex.lock();
+        writer_closed = true;
+        cond.broadcast();
+        mutex.unlock();
+        poll_state_changed();
+    }
+
+    public void close_reader() {
+        mutex.lock();
+        reader_closed = true;
+        chunks.clear();
+        n_buffered = 0;
+        head_offset = 0;
+        cond.broadcast();
+        mutex.unlock();
+        poll_state_changed();
+    }
+}
+
+internal class PipeInputStream : InputStream, PollableInputStream {
+    public PipeBuffer buffer { get; construct; }
+
+    public PipeInputStream(PipeBuffer buffer) {
+        Object(buffer: buffer);
+    }
+
+    public override ssize_t read([CCode(array_length_type = "gsize")] uint8[] buffer,
+        Cancellable? cancellable = null) throws IOError
+    {
+        return copy_out(this.buffer.pop(buffer.length, true, cancellable), buffer);
+    }
+
+    private static ssize_t copy_out(Bytes data, uint8[] buffer) {
+        Memory.copy(buffer, data.get_data(), data.get_size());
+        return (ssize_t) data.get_size();
+    }
+
+    public override bool close(Cancellable? cancellable = null) throws IOError {
+        buffer.close_reader();
+        return true;
+    }
+
+    public bool can_poll() {
+        return true;
+    }
+
+    public bool is_readable() {
+        return buffer.get_read_readiness() == 0;
+    }
+
+    public PollableSource create_source(Cancellable? cancellable = null) {
+        var ready_source = new ReadySource(buffer, buffer.get_read_readiness);
+        return new PollableSource.full(this, ready_source, cancellable);
+    }
+
+    public ssize_t read_nonblocking_fn([CCode(array_length_type = "gsize")] uint8[] buffer)
+        throws Error
+    {
+        return copy_out(this.buffer.pop(buffer.length, false, null), buffer);
+    }
+}
+
+internal class PipeOutputStream : OutputStream, PollableOutputStream {
+    public PipeBuffer buffer { get; construct; }
+
+    public PipeOutputStream(PipeBuffer buffer) {
+        Object(buffer: buffer);
+    }
+
+    public override ssize_t write([CCode(array_length_type = "gsize")] uint8[] buffer,
+        Cancellable? cancellable = null) throws IOError
+    {
+        return (ssize_t) this.buffer.push(new Bytes(buffer), true, cancellable);
+    }
+
+    public override bool close(Cancellable? cancellable = null) throws IOError {
+        buffer.close_writer();
+        return true;
+    }
+
+    public bool can_poll() {
+        return true;
+    }
+
+    public bool is_writable() {
+        return buffer.get_write_readiness() == 0;
+    }
+
+    public PollableSource create_source(Cancellable? cancellable = null) {
+        var ready_source = new ReadySource(buffer, buffer.get_write_readiness);
+        return new PollableSource.full(this, ready_source, cancellable);
+    }
+
+    public ssize_t write_nonblocking_fn([CCode(array_length_type = "gsize")] uint8[] buffer)
+        throws Error
+    {
+        return (ssize_t) this.buffer.push(new Bytes(buffer), false, null);
+    }
+}
+
+/**
+ * One end of a connected pair of in-memory streams
+ *
+ * Whatever is written to the output stream of one end of the pipe can be read
+ * from the input stream of the other end, like with a pair of connected
+ * sockets.
+ * Create the pair with gt_mock_pipe_new_pair().
+ * A mock pipe created on its own with g_object_new() is connected to itself.
+ *
+ * Each direction has a buffer of a fixed capacity.
+ * When it is full, writing blocks until the other end reads some data, and
+ * the non-blocking and async paths of the streams, which implement
+ * #GPollableOutputStream and #GPollableInputStream, see %G_IO_ERROR_WOULD_BLOCK.
+ * The streams can be used from different threads.
+ *
+ * Use gt_mock_pipe_send_bytes() and gt_mock_pipe_receive_bytes() to pass data
+ * through the pipe without copying it.
+ *
+ * Closing the output stream of one end makes the input stream of the other
+ * end reach end-of-file once it has read everything.
+ * Closing the input stream of one end makes writing to the other end fail
+ * with %G_IO_ERROR_BROKEN_PIPE.
+ */
+public class MockPipe : IOStream {
+    private PipeInputStream input;
+    private PipeOutputStream output;
+
+    // The buffers read from and written to. A pipe created directly with
+    // g_object_new() has neither, and gets one buffer looping back to itself.
+    internal PipeBuffer? incoming { get; construct; }
+    internal PipeBuffer? outgoing { get; construct; }
+
+    /**
+     * Maximum number of bytes that can be written to this end and not yet be
+     * read from the other end.
+     */
+    public size_t capacity { get; construct; default = 64 * 1024; }
+
+    private MockPipe(PipeBuffer incoming, PipeBuffer outgoing) {
+        Object(incoming: incoming, outgoing: outgoing,
+            capacity: outgoing.capacity);
+    }
+
+    construct {
+        PipeBuffer? loopback = null;
+        if (incoming == null || outgoing == null)
+            loopback = new PipeBuffer(capacity);
+        input = new PipeInputStream(incoming ?? loopback);
+        output = new PipeOutputStream(outgoing ?? loopback);
+    }
+
+    /**
+     * Creates two mock pipe ends that are connected to each other.
+     *
+     * @param capacity Size of the buffer in each direction, in bytes
+     * @param first Return location for one end
+     * @param second Return location for the other end
+     */
+    public static void new_pair(size_t capacity, out MockPipe first,
+        out MockPipe second)
+        requires(capacity > 0)
+    {
+        var forward = new PipeBuffer(capacity);
+        var backward = new PipeBuffer(capacity);
+        first = new MockPipe(backward, forward);
+        second = new MockPipe(forward, backward);
+    }
+
+    public override unowned InputStream get_input_stream() {
+        return input;
+    }
+
+    public override unowned OutputStream get_output_stream() {
+        return output;
+    }
+
+    /**
+     * Writes all of @data to the pipe without copying it; the other end
+     * receives the same memory.
+     * Blocks while the pipe is full.
+     *
+     * @param data Data to write
+     * @param cancellable optional #GCancellable object
+     * @throws Error if either end was closed, if the output stream has an
+     * outstanding operation, or on cancellation
+     */
+    public void send_bytes(Bytes data, Cancellable? cancellable = null)
+        throws Error
+    {
+        output.set_pending();
+        try {
+            size_t written = 0;
+            while (written < data.get_size()) {
+                var remaining = written == 0 ? data :
+                    new Bytes.from_bytes(data, written, data.get_size() - written);
+                written += output.buffer.push(remaining, true, cancellable);
+            }
+        } finally {
+            output.clear_pending();
+        }
+    }
+
+    /**
+     * Reads up to @max_count bytes from the pipe without copying them.
+     * Blocks while the pipe is empty.
+     * Returns fewer bytes than were written at once if they were written in
+     * smaller pieces or did not fit in the pipe all at once.
+     *
+     * @param max_count Maximum number of bytes to read
+     * @param cancellable optional #GCancellable object
+     * @return the data, or an empty #GBytes at end-of-file
+     * @throws Error if the input stream was closed or has an outstanding
+     * operation, or on cancellation
+     */
+    public Bytes receive_bytes(size_t max_count, Cancellable? cancellable = null)
+        throws Error
+    {
+        input.set_pending();
+        try {
+            return input.buffer.pop(max_count, true, cancellable);
+        } finally {
+            input.clear_pending();
+        }
+    }
+}
+}  // namespace Gt
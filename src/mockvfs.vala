@@ -20,6 +20,24 @@ namespace Gt {
 public class MockVfs : Vfs {
     private static const string URI_SCHEME = "gt-mock";
 
+    /**
+     * Fault injector given to every mock file that this VFS creates from a URI
+     * or parse name.
+     */
+    public FaultInjector? fault_injector { get; set; }
+
+    /**
+     * Mock arena given to every mock file that this VFS creates from a URI
+     * or parse name.
+     * In a process started with the `GT_MOCK_ARENA_FD` environment variable
+     * set, this is the arena that the variable refers to.
+     */
+    public MockArena? arena { get; set; }
+
+    construct {
+        arena = MockArena.from_environment();
+    }
+
     public override bool is_active() {
         return true;
     }
@@ -36,7 +54,10 @@ public class MockVfs : Vfs {
         if ("#" in id)
             id = id[id.index_of_char('#'):id.length];
 
-        return new MockFile.with_id(id);
+        var file = new MockFile.with_id(id);
+        file.fault_injector = fault_injector;
+        file.arena = arena;
+        return file;
     }
 
     public override File parse_name(string name) {
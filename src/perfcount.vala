@@ -0,0 +1,216 @@
+/*
+ * Copyright 2026 The Gt authors
+ *
+ * This file is part of Gt.
+ *
+ * Gt is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * Gt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Gt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gt {
+#if HAVE_PERF_EVENT
+// perf_event_open() has no wrapper in libc
+[CCode (cname = "syscall", cheader_filename = "unistd.h,sys/syscall.h")]
+private extern long syscall(long number, ...);
+[CCode (cname = "SYS_perf_event_open", cheader_filename = "sys/syscall.h")]
+private extern const long SYS_perf_event_open;
+
+[CCode (cname = "struct perf_event_attr", cheader_filename = "linux/perf_event.h",
+    destroy_function = "", has_type_id = false)]
+private struct PerfEventAttr {
+    public uint32 type;
+    public uint32 size;
+    public uint64 config;
+    public uint inherit;  // bit field
+}
+
+[CCode (cname = "PERF_TYPE_SOFTWARE", cheader_filename = "linux/perf_event.h")]
+private extern const uint32 PERF_TYPE_SOFTWARE;
+[CCode (cname = "PERF_COUNT_SW_TASK_CLOCK", cheader_filename = "linux/perf_event.h")]
+private extern const uint64 PERF_COUNT_SW_TASK_CLOCK;
+[CCode (cname = "PERF_COUNT_SW_CONTEXT_SWITCHES", cheader_filename = "linux/perf_event.h")]
+private extern const uint64 PERF_COUNT_SW_CONTEXT_SWITCHES;
+[CCode (cname = "PERF_COUNT_SW_CPU_MIGRATIONS", cheader_filename = "linux/perf_event.h")]
+private extern const uint64 PERF_COUNT_SW_CPU_MIGRATIONS;
+[CCode (cname = "PERF_COUNT_SW_PAGE_FAULTS_MIN", cheader_filename = "linux/perf_event.h")]
+private extern const uint64 PERF_COUNT_SW_PAGE_FAULTS_MIN;
+[CCode (cname = "PERF_COUNT_SW_PAGE_FAULTS_MAJ", cheader_filename = "linux/perf_event.h")]
+private extern const uint64 PERF_COUNT_SW_PAGE_FAULTS_MAJ;
+#endif
+
+[CCode (cname = "struct rusage", cheader_filename = "sys/resource.h",
+    destroy_function = "", has_type_id = false)]
+private struct Rusage {
+    public Posix.timeval ru_utime;
+    public Posix.timeval ru_stime;
+    public long ru_minflt;
+    public long ru_majflt;
+    public long ru_nvcsw;
+    public long ru_nivcsw;
+}
+
+[CCode (cname = "getrusage", cheader_filename = "sys/resource.h")]
+private extern int getrusage(int who, out Rusage usage);
+[CCode (cname = "RUSAGE_SELF", cheader_filename = "sys/resource.h")]
+private extern const int RUSAGE_SELF;
+#if HAVE_RUSAGE_THREAD
+[CCode (cname = "RUSAGE_THREAD", cheader_filename = "sys/resource.h")]
+private extern const int RUSAGE_THREAD;
+#endif
+
+/**
+ * Which code gt_measure_perf_counts() measures.
+ */
+public enum PerfScope {
+    /**
+     * Only the calling thread, if the system can count per thread; otherwise,
+     * the whole process.
+     */
+    THREAD,
+    /**
+     * With perf events, the calling thread and any threads that it starts
+     * while the block is running.
+     * The kernel only adds a started thread's counts once that thread has
+     * exited, so join any threads before the block returns, or their work is
+     * not counted.
+     * Without perf events, the whole process, including threads that were
+     * already running.
+     */
+    PROCESS
+}
+
+/**
+ * Software performance counters, as measured by gt_measure_perf_counts().
+ */
+public struct PerfCounts {
+    /** CPU time used, in nanoseconds */
+    public uint64 task_clock;
+    /** Number of context switches */
+    public uint64 context_switches;
+    /** Number of times the code moved to another CPU; always 0 without perf events */
+    public uint64 cpu_migrations;
+    /** Number of page faults that didn't need I/O */
+    public uint64 minor_faults;
+    /** Number of page faults that needed I/O */
+    public uint64 major_faults;
+    /**
+     * Whether the counts came from perf events; if false, they came from
+     * getrusage(), which is less precise
+     */
+    public bool from_perf_events;
+}
+
+#if HAVE_PERF_EVENT
+// Opens a software perf event counting for the calling thread, or returns -1.
+// With inherit set, the counts of threads started afterwards are added when
+// they exit.
+private int open_perf_event(uint64 config, PerfScope scope) {
+    var attr = PerfEventAttr();
+    Memory.set(&attr, 0, sizeof(PerfEventAttr));
+    attr.type = PERF_TYPE_SOFTWARE;
+    attr.size = (uint32) sizeof(PerfEventAttr);
+    attr.config = config;
+    attr.inherit = scope == PerfScope.PROCESS ? 1 : 0;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+private uint64 read_perf_event(int fd) {
+    uint64 value = 0;
+    if (Posix.read(fd, &value, sizeof(uint64)) != sizeof(uint64))
+        return 0;
+    return value;
+}
+#endif
+
+private uint64 timeval_to_ns(Posix.timeval time) {
+    return (uint64) time.tv_sec * 1000000000 + (uint64) time.tv_usec * 1000;
+}
+
+/**
+ * Measures the software performance counters of the kernel while running a
+ * block of code.
+ * This is only available on Linux.
+ *
+ * The counters are read with perf_event_open().
+ * If that isn't allowed, for example because of the `perf_event_paranoid`
+ * setting or a container's seccomp policy, or Gt was built without perf event
+ * support, they are read with getrusage() instead, which has a coarser
+ * resolution and can't count CPU migrations.
+ * In that case, #GtPerfCounts.from_perf_events is false.
+ * See #GtPerfScope for which threads are counted in each case.
+ *
+ * For example, use this to assert that reading a mapped mock file causes no
+ * major page faults.
+ *
+ * @param scope Which threads to measure
+ * @param block Code to run
+ * @param counts Return location for the differences in the counters between
+ * before and after running @block
+ */
+public void measure_perf_counts(PerfScope scope, Block block, out PerfCounts counts) {
+    counts = PerfCounts();
+#if HAVE_PERF_EVENT
+    uint64[] events = {
+        PERF_COUNT_SW_TASK_CLOCK,
+        PERF_COUNT_SW_CONTEXT_SWITCHES,
+        PERF_COUNT_SW_CPU_MIGRATIONS,
+        PERF_COUNT_SW_PAGE_FAULTS_MIN,
+        PERF_COUNT_SW_PAGE_FAULTS_MAJ
+    };
+    var fds = new int[events.length];
+    var available = true;
+    for (var ix = 0; ix < events.length; ix++) {
+        fds[ix] = available ? open_perf_event(events[ix], scope) : -1;
+        available = available && fds[ix] != -1;
+    }
+
+    if (available) {
+        var before = new uint64[events.length];
+        for (var ix = 0; ix < events.length; ix++)
+            before[ix] = read_perf_event(fds[ix]);
+        block();
+        var after = new uint64[events.length];
+        for (var ix = 0; ix < events.length; ix++)
+            after[ix] = read_perf_event(fds[ix]);
+        counts.task_clock = after[0] - before[0];
+        counts.context_switches = after[1] - before[1];
+        counts.cpu_migrations = after[2] - before[2];
+        counts.minor_faults = after[3] - before[3];
+        counts.major_faults = after[4] - before[4];
+        counts.from_perf_events = true;
+    }
+    foreach (var fd in fds) {
+        if (fd != -1)
+            Posix.close(fd);
+    }
+    if (available)
+        return;
+#endif
+
+    // Without per-thread resource usage, both scopes measure the whole process
+    var who = RUSAGE_SELF;
+#if HAVE_RUSAGE_THREAD
+    if (scope == PerfScope.THREAD)
+        who = RUSAGE_THREAD;
+#endif
+    Rusage before, after;
+    getrusage(who, out before);
+    block();
+    getrusage(who, out after);
+    counts.task_clock = timeval_to_ns(after.ru_utime) + timeval_to_ns(after.ru_stime) -
+        timeval_to_ns(before.ru_utime) - timeval_to_ns(before.ru_stime);
+    counts.context_switches = (after.ru_nvcsw + after.ru_nivcsw) -
+        (before.ru_nvcsw + before.ru_nivcsw);
+    counts.minor_faults = after.ru_minflt - before.ru_minflt;
+    counts.major_faults = after.ru_majflt - before.ru_majflt;
+}
+}  // namespace Gt
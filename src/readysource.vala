@@ -0,0 +1,74 @@
+/*
+ * Copyright 2026 The Gt authors
+ *
+ * This file is part of Gt.
+ *
+ * Gt is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * Gt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Gt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gt {
+// Returns 0 if a mock stream can be read from or written to without blocking,
+// the monotonic time at which it will become ready if it is being throttled,
+// or -1 if it won't become ready until the mock file changes.
+internal delegate int64 ReadinessFunc();
+
+// Source that becomes ready when a mock stream does. It is used as the child
+// of the GPollableSource returned from the streams' create_source(), so it is
+// dispatched on whichever main context the caller attaches that to, and there
+// is no thread or file descriptor involved.
+// Instead of polling, the source is woken up by the poll-state-changed signal
+// of the object that the stream reads from or writes to, such as the mock
+// file, or by its ready time when throttled. The signal may be emitted from
+// any thread.
+internal class ReadySource : Source {
+    private Object emitter;
+    private ReadinessFunc readiness;
+    private ulong handler;
+
+    public ReadySource(Object emitter, owned ReadinessFunc readiness) {
+        this.emitter = emitter;
+        this.readiness = (owned) readiness;
+        handler = Signal.connect_swapped(emitter, "poll-state-changed",
+            (Callback) ReadySource.wake, this);
+    }
+
+    ~ReadySource() {
+        SignalHandler.disconnect(emitter, handler);
+    }
+
+    public void wake() {
+        set_ready_time(0);
+    }
+
+    // A wakeup only interrupts the poll; readiness is decided here, both
+    // before and after polling
+    private bool update() {
+        var ready_time = readiness();
+        set_ready_time(ready_time > 0 ? ready_time : -1);
+        return ready_time == 0;
+    }
+
+    protected override bool prepare(out int timeout) {
+        timeout = -1;
+        return update();
+    }
+
+    protected override bool check() {
+        return update();
+    }
+
+    protected override bool dispatch(SourceFunc? callback) {
+        return callback == null || callback();
+    }
+}
+}  // namespace Gt
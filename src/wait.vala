@@ -26,10 +26,128 @@ public delegate void AsyncBegin(AsyncReadyCallback callback);
 public delegate void CancellableAsyncBegin(Cancellable cancel,
     AsyncReadyCallback callback);
 public delegate void AsyncFinish(AsyncResult result);
+public delegate void IndexedAsyncBegin(uint index, AsyncReadyCallback callback);
+public delegate void IndexedAsyncFinish(uint index, AsyncResult result);
+
+/**
+ * When gt_wait_for_many_async() stops waiting, apart from its timeout.
+ */
+public enum WaitForMany {
+    /** When all of the operations have completed */
+    ALL,
+    /** As soon as any of the operations has completed */
+    FIRST
+}
+
+/**
+ * Statistics about a wait, returned from the timed variants of the wait
+ * functions such as gt_wait_for_condition_timed().
+ */
+public struct WaitStats {
+    /**
+     * How long the wait took, in microseconds of monotonic time, including
+     * starting the operation that was waited for
+     */
+    public int64 elapsed;
+    /** Number of emissions of the signal that were seen during the wait */
+    public uint n_emissions;
+    /** Number of main loop iterations that were run during the wait */
+    public uint n_iterations;
+}
+
+// Source that is dispatched once a monotonic time in microseconds has passed.
+// Timeout.add() only has a resolution of milliseconds.
+[CCode (cname = "_gt_is_main_thread")]
+private extern bool is_main_thread();
+
+private class DeadlineSource : Source {
+    public DeadlineSource(int64 ready_time) {
+        set_ready_time(ready_time);
+    }
+
+    protected override bool prepare(out int timeout) {
+        timeout = -1;
+        return false;
+    }
+
+    protected override bool check() {
+        return false;
+    }
+
+    protected override bool dispatch(SourceFunc? callback) {
+        return callback != null && callback();
+    }
+}
+
+// Runs a main context until finish() is called, keeping statistics for
+// WaitStats. The elapsed time is measured from when the loop was created, so
+// it includes starting the operation that is waited for. Deadlines are
+// measured from when they are added, like with Timeout.add().
+//
+// The context is the calling thread's thread-default context. If none was
+// pushed, that is the global default context on the main thread; other
+// threads get a new context, so that they never dispatch the main thread's
+// sources. If another thread is already running the context, the wait also
+// gets a new context, so that it doesn't have to wait for the other thread
+// to give it up. The context is acquired on creation, and pushed if it is
+// new, so that sources that the code under test creates afterwards are
+// attached to it. run() releases it again.
+private class TimedLoop {
+    public WaitStats stats = WaitStats();
+    private MainContext? context;
+    private bool pushed = false;
+    private int64 start = get_monotonic_time();
+    private int finished = 0;
+    private SList<Source> deadlines;
+
+    public TimedLoop() {
+        context = MainContext.get_thread_default();
+        if (context == null && is_main_thread())
+            context = MainContext.default();
+        // Acquiring succeeds if this thread already owns the context
+        if (context == null || !context.acquire()) {
+            context = new MainContext();
+            context.acquire();
+            context.push_thread_default();
+            pushed = true;
+        }
+    }
+
+    public void add_deadline(int64 timeout, owned SourceFunc func) {
+        var source = new DeadlineSource(get_monotonic_time() + timeout);
+        source.set_callback((owned) func);
+        source.attach(context);
+        deadlines.prepend(source);
+    }
+
+    // Can be called from any thread, for example from a signal emitted in
+    // another thread
+    public void finish() {
+        AtomicInt.set(ref finished, 1);
+        context.wakeup();
+    }
+
+    // Returns immediately if finish() was already called
+    public void run() {
+        while (AtomicInt.get(ref finished) == 0) {
+            context.iteration(true);
+            stats.n_iterations++;
+        }
+        stats.elapsed = get_monotonic_time() - start;
+        foreach (var source in deadlines) {
+            if (!source.is_destroyed())
+                source.destroy();
+        }
+        if (pushed)
+            context.pop_thread_default();
+        context.release();
+    }
+}
 
 private class SignalWaiter {
-    public MainLoop loop = new MainLoop(MainContext.default(), true);
+    public TimedLoop loop = new TimedLoop();
     public bool succeeded = false;
+    public uint n_emissions = 0;
     public unowned Predicate predicate;
 
     public SignalWaiter(Predicate predicate) {
@@ -37,16 +155,16 @@ private class SignalWaiter {
     }
 
     public int callback() {
-        if (predicate()) {
-            succeeded = true;
-            loop.quit();
-        }
+        n_emissions++;
+        check();
         return 0;
     }
 
-    public bool abort() {
-        loop.quit();
-        return false;
+    public void check() {
+        if (!succeeded && predicate()) {
+            succeeded = true;
+            loop.finish();
+        }
     }
 }
 
@@ -59,6 +177,14 @@ private class SignalWaiter {
  * signal completion when the first emission does not necessarily imply the
  * desired state was reached.
  *
+ * Like all the wait functions, this runs the calling thread's thread-default
+ * main context, so it can be used from several threads at once.
+ * Threads other than the main thread never run the global default context.
+ * If they have no thread-default context, or another thread is already
+ * running it, a new one is pushed for the duration of the wait, so async
+ * operations started from @block that report their results to the
+ * thread-default context complete in that thread.
+ *
  * @param timeout Maximum timeout to wait for the emission, in milliseconds.
  * @param emitter The object that will emit signal.
  * @param signame Name of the signal to wait for. May include detail (in the
@@ -74,9 +200,29 @@ private class SignalWaiter {
 public bool wait_for_condition(int timeout, Object emitter, string signame,
     owned Predicate predicate, Block? block)
 {
-    // FIXME: The fixture should push a new context in set_up and pop it back on
-    // clean-up! (But it's GLib 2.21.0+ and I still have 2.20.4)
+    return wait_for_condition_timed((int64) timeout * 1000, emitter, signame,
+        (owned) predicate, block, null);
+}
 
+/**
+ * Wait until a condition becomes true, and measure the wait.
+ *
+ * Like gt_wait_for_condition(), but the timeout is in microseconds, and
+ * statistics about the wait are returned in @stats.
+ *
+ * @param timeout Maximum timeout to wait for the condition, in microseconds.
+ * @param emitter The object that will emit signal.
+ * @param signame Name of the signal to wait for.
+ * @param predicate Function that will be called to test whether the waited-for
+ * condition occured.
+ * @param block Function that will start the asynchronous operation.
+ * @param stats Return location for statistics about the wait, or null.
+ * @return true if the condition became true, false otherwise.
+ */
+public bool wait_for_condition_timed(int64 timeout, Object emitter,
+    string signame, owned Predicate predicate, Block? block,
+    out WaitStats stats)
+{
     var waiter = new SignalWaiter(predicate);
     var sh = Signal.connect_swapped(emitter, signame,
         (Callback) SignalWaiter.callback, waiter);
@@ -85,17 +231,17 @@ public bool wait_for_condition(int timeout, Object emitter, string signame,
         block();
 
     // Check whether the condition is not true already
-    waiter.callback();
+    waiter.check();
     // Plan timeout
-    var t1 = Timeout.add(timeout, waiter.abort);
-    // Run the loop if it was not quit yet.
-    if(waiter.loop.is_running())
-        waiter.loop.run();
+    waiter.loop.add_deadline(timeout, () => {
+        waiter.loop.finish();
+        return false;
+    });
+    waiter.loop.run();
 
     SignalHandler.disconnect(emitter, sh);
-    // Cancel timer unless it aborted the operation
-    if (waiter.succeeded)
-        Source.remove(t1);
+    stats = waiter.loop.stats;
+    stats.n_emissions = waiter.n_emissions;
     return waiter.succeeded;
 }
 
@@ -119,14 +265,34 @@ public bool wait_for_condition(int timeout, Object emitter, string signame,
  */
 public bool wait_for_signal(int timeout, Object emitter, string signame,
     Block? block)
+{
+    return wait_for_signal_timed((int64) timeout * 1000, emitter, signame,
+        block, null);
+}
+
+/**
+ * Wait for signal to be emitted, and measure the wait.
+ *
+ * Like gt_wait_for_signal(), but the timeout is in microseconds, and
+ * statistics about the wait are returned in @stats.
+ *
+ * @param timeout Maximum timeout to wait for the emission, in microseconds.
+ * @param emitter The object that will emit signal.
+ * @param signame Name of the signal to wait for.
+ * @param block Function that will start the asynchronous operation.
+ * @param stats Return location for statistics about the wait, or null.
+ * @return true if the signal was emitted, false otherwise.
+ */
+public bool wait_for_signal_timed(int64 timeout, Object emitter,
+    string signame, Block? block, out WaitStats stats)
 {
     bool condition = false;
-    return wait_for_condition(timeout, emitter, signame, () => {
+    return wait_for_condition_timed(timeout, emitter, signame, () => {
         if (condition)
             return true;
         condition = true;
         return false;
-    }, block);
+    }, block, out stats);
 }
 
 /**
@@ -138,8 +304,8 @@ public bool wait_for_signal(int timeout, Object emitter, string signame,
  * loop is entered again later.
  * By that time, the callback data will be destroyed and the callback will crash.
  *
- * This should be avoided by setting new GLib.MainContext for each test case,
- * but that is only available in development 2.21 GLib.
+ * This can be avoided by pushing a new thread-default GLib.MainContext for
+ * each test case.
  *
  * @param timeout Maximum timeout to wait for completion, in milliseconds.
  * @param async_function The async function to call.
@@ -156,26 +322,43 @@ public bool wait_for_signal(int timeout, Object emitter, string signame,
 public bool wait_for_async(int timeout, AsyncBegin async_function,
     AsyncFinish async_finish)
 {
-    var loop = new MainLoop(MainContext.default(), true);
+    return wait_for_async_timed((int64) timeout * 1000, async_function,
+        async_finish, null);
+}
+
+/**
+ * Wait for an async operation to complete, and measure the wait.
+ *
+ * Like gt_wait_for_async(), but the timeout is in microseconds, and
+ * statistics about the wait are returned in @stats.
+ * The same warning applies.
+ *
+ * @param timeout Maximum timeout to wait for completion, in microseconds.
+ * @param async_function The async function to call.
+ * @param async_finish The finish part of the async function.
+ * @param stats Return location for statistics about the wait, or null.
+ * @return true if the function completed and passed the check, false otherwise.
+ */
+public bool wait_for_async_timed(int64 timeout, AsyncBegin async_function,
+    AsyncFinish async_finish, out WaitStats stats)
+{
+    var loop = new TimedLoop();
     AsyncResult? result = null;
     // Plan the async function
     async_function((o, r) => {
         result = r;
-        loop.quit();
+        loop.finish();
     });
     // Plan timeout
-    var t1 = Timeout.add(timeout, () => {
-        loop.quit();
+    loop.add_deadline(timeout, () => {
+        loop.finish();
         return false;
     });
-    // Run the loop if it was not quit yet.
-    if (loop.is_running())
-        loop.run();
+    loop.run();
+    stats = loop.stats;
     // Check the outcome
     if (result == null)
         return false;
-    else
-        Source.remove(t1);
     async_finish(result);
     return true;
 }
@@ -192,8 +375,8 @@ public bool wait_for_async(int timeout, AsyncBegin async_function,
  * may run to completion when main loop is entered again later.
  * By that time, the callback data will be destroyed and the callback will crash.
  *
- * This should be avoided by setting new GLib.MainContext for each test case,
- * but that is only available in development 2.21 GLib.
+ * This can be avoided by pushing a new thread-default GLib.MainContext for
+ * each test case.
  *
  * @param timeout Maximum timeout to wait for completion, in milliseconds.
  * @param async_function The async function to call.
@@ -211,37 +394,266 @@ public bool wait_for_async(int timeout, AsyncBegin async_function,
 public bool wait_for_cancellable_async(int timeout,
     CancellableAsyncBegin async_function, AsyncFinish async_finish)
 {
-    var loop = new MainLoop(MainContext.default(), true);
+    return wait_for_cancellable_async_timed((int64) timeout * 1000,
+        async_function, async_finish, null);
+}
+
+/**
+ * Wait for cancellable async operation to complete, and measure the wait.
+ *
+ * Like gt_wait_for_cancellable_async(), but the timeout is in microseconds,
+ * and statistics about the wait are returned in @stats.
+ * The same warning applies.
+ *
+ * @param timeout Maximum timeout to wait for completion, in microseconds.
+ * @param async_function The async function to call.
+ * @param async_finish The finish part of the async function.
+ * @param stats Return location for statistics about the wait, or null.
+ * @return true if the function completed (without being cancelled) and passed
+ * the check, false otherwise.
+ */
+public bool wait_for_cancellable_async_timed(int64 timeout,
+    CancellableAsyncBegin async_function, AsyncFinish async_finish,
+    out WaitStats stats)
+{
+    var loop = new TimedLoop();
     AsyncResult? result = null;
     var cancel = new Cancellable();
     // Plan the async function
     async_function(cancel, (o, r) => {
         result = r;
-        loop.quit();
+        loop.finish();
     });
     // Plan timeouts
-    var t1 = Timeout.add(timeout, () => {
+    loop.add_deadline(timeout, () => {
         cancel.cancel();
         return false;
     });
-    var t2 = Timeout.add(2 * timeout, () => {
-        loop.quit();
+    loop.add_deadline(2 * timeout, () => {
+        loop.finish();
         return false;
     });
-    // Run the loop if it was not quit yet.
-    if(loop.is_running())
-        loop.run();
+    loop.run();
+    stats = loop.stats;
 
     // Check the outcome
     if (result == null)
         return false; // The async wasn't called at all.
-    else
-        Source.remove(t2);
     if (cancel.is_cancelled()) // Only succeed if not cancelled
         return false;
-    else
-        Source.remove(t1);
     async_finish(result);
     return true;
 }
-}  // namespace Gt
\ No newline at end of file
+
+// One of the operations started by wait_for_many_async(). If the wait ends
+// before the operation completes, the operation keeps itself alive until its
+// callback is called, and then ignores the result.
+private class PendingOperation {
+    public AsyncResult? result = null;
+    public int64 completion_time = -1;
+    private ManyWaiter waiter;
+    private PendingOperation? abandoned_self = null;
+
+    public PendingOperation(ManyWaiter waiter) {
+        this.waiter = waiter;
+    }
+
+    public void abandon() {
+        abandoned_self = this;
+    }
+
+    public void on_ready(Object? source, AsyncResult result) {
+        if (abandoned_self != null) {
+            abandoned_self = null;  // may free this
+            return;
+        }
+        this.result = result;
+        completion_time = get_monotonic_time() - waiter.start;
+        waiter.operation_completed();
+    }
+}
+
+private class ManyWaiter {
+    public TimedLoop loop = new TimedLoop();
+    public int64 start = get_monotonic_time();
+    public uint n_completed = 0;
+    private uint n_operations;
+    private WaitForMany mode;
+
+    public ManyWaiter(uint n_operations, WaitForMany mode) {
+        this.n_operations = n_operations;
+        this.mode = mode;
+    }
+
+    public void operation_completed() {
+        n_completed++;
+        if (mode == WaitForMany.FIRST || n_completed == n_operations)
+            loop.finish();
+    }
+}
+
+/**
+ * Wait for many async operations to complete at the same time.
+ *
+ * Starts @n_operations async operations, all at once, and runs one main loop
+ * until all of them have completed, or until the first one has completed,
+ * depending on @mode, or until @timeout has passed.
+ * This can be used to test how code behaves when operations overlap, for
+ * example many reads on mock files at once.
+ *
+ * After the wait, @async_finish is called for each operation that completed,
+ * in order of index.
+ * Operations that had not completed when the wait ended may still complete
+ * when the main loop is run again later; their results are ignored.
+ *
+ * @param timeout Maximum time to wait, in microseconds.
+ * @param n_operations Number of operations to start.
+ * @param async_function Function that starts one operation; it is called with
+ * each index from 0 to @n_operations - 1.
+ * @param async_finish The finish part of the async function.
+ * @param mode Whether to wait for all of the operations or only the first.
+ * @param completion_times Return location for the time at which each
+ * operation completed, in microseconds since the operations were started, or
+ * -1 for operations that didn't complete.
+ * @param stats Return location for statistics about the wait, or null.
+ * @return true if all of the operations completed, or with
+ * %GT_WAIT_FOR_MANY_FIRST, if at least one did.
+ */
+public bool wait_for_many_async(int64 timeout, uint n_operations,
+    IndexedAsyncBegin async_function, IndexedAsyncFinish async_finish,
+    WaitForMany mode, out int64[] completion_times, out WaitStats stats)
+{
+    var waiter = new ManyWaiter(n_operations, mode);
+    // Keep the operations alive for as long as their callbacks can be called
+    var operations = new PendingOperation[n_operations];
+    for (uint ix = 0; ix < n_operations; ix++)
+        operations[ix] = new PendingOperation(waiter);
+    if (n_operations == 0)
+        waiter.loop.finish();
+    // Start them all before running the loop
+    for (uint ix = 0; ix < n_operations; ix++)
+        async_function(ix, operations[ix].on_ready);
+    waiter.loop.add_deadline(timeout, () => {
+        waiter.loop.finish();
+        return false;
+    });
+    waiter.loop.run();
+    stats = waiter.loop.stats;
+
+    completion_times = new int64[n_operations];
+    for (uint ix = 0; ix < n_operations; ix++) {
+        completion_times[ix] = operations[ix].completion_time;
+        if (operations[ix].result != null)
+            async_finish(ix, operations[ix].result);
+        else
+            operations[ix].abandon();
+    }
+    if (mode == WaitForMany.FIRST)
+        return waiter.n_completed > 0;
+    return waiter.n_completed == n_operations;
+}
+
+// Fails the test because something took longer than @budget microseconds
+private void fail_over_budget(string what, int64 budget, WaitStats stats) {
+    Test.message("%s did not complete within %" + int64.FORMAT + " µs " +
+        "(gave up after %" + int64.FORMAT + " µs, %u main loop iterations, " +
+        "%u signal emissions)", what, budget, stats.elapsed,
+        stats.n_iterations, stats.n_emissions);
+    Test.fail();
+}
+
+/**
+ * Fails the current test unless a condition becomes true within a time
+ * budget.
+ *
+ * This is like gt_wait_for_condition_timed(), but calls g_test_fail() if the
+ * condition doesn't become true in time, so that latency regressions cause
+ * test failures directly.
+ *
+ * @param budget Time budget, in microseconds.
+ * @param emitter The object that will emit signal.
+ * @param signame Name of the signal to wait for.
+ * @param predicate Function that will be called to test whether the waited-for
+ * condition occured.
+ * @param block Function that will start the asynchronous operation.
+ * @return true if the condition became true within the budget.
+ */
+public bool assert_condition_within(int64 budget, Object emitter,
+    string signame, owned Predicate predicate, Block? block)
+{
+    WaitStats stats;
+    if (wait_for_condition_timed(budget, emitter, signame, (owned) predicate,
+        block, out stats))
+        return true;
+    fail_over_budget("Condition on signal %s".printf(signame), budget, stats);
+    return false;
+}
+
+/**
+ * Fails the current test unless a signal is emitted within a time budget.
+ *
+ * See gt_assert_condition_within().
+ *
+ * @param budget Time budget, in microseconds.
+ * @param emitter The object that will emit signal.
+ * @param signame Name of the signal to wait for.
+ * @param block Function that will start the asynchronous operation.
+ * @return true if the signal was emitted within the budget.
+ */
+public bool assert_signal_within(int64 budget, Object emitter, string signame,
+    Block? block)
+{
+    WaitStats stats;
+    if (wait_for_signal_timed(budget, emitter, signame, block, out stats))
+        return true;
+    fail_over_budget("Signal %s".printf(signame), budget, stats);
+    return false;
+}
+
+/**
+ * Fails the current test unless an async operation completes within a time
+ * budget.
+ *
+ * See gt_assert_condition_within().
+ * The warning from gt_wait_for_async() applies if the operation doesn't
+ * complete in time.
+ *
+ * @param budget Time budget, in microseconds.
+ * @param async_function The async function to call.
+ * @param async_finish The finish part of the async function.
+ * @return true if the operation completed within the budget.
+ */
+public bool assert_async_within(int64 budget, AsyncBegin async_function,
+    AsyncFinish async_finish)
+{
+    WaitStats stats;
+    if (wait_for_async_timed(budget, async_function, async_finish, out stats))
+        return true;
+    fail_over_budget("Async operation", budget, stats);
+    return false;
+}
+
+/**
+ * Fails the current test unless a cancellable async operation completes
+ * within a time budget.
+ * If it doesn't, the operation is cancelled, as in
+ * gt_wait_for_cancellable_async().
+ *
+ * See gt_assert_condition_within().
+ *
+ * @param budget Time budget, in microseconds.
+ * @param async_function The async function to call.
+ * @param async_finish The finish part of the async function.
+ * @return true if the operation completed within the budget.
+ */
+public bool assert_cancellable_async_within(int64 budget,
+    CancellableAsyncBegin async_function, AsyncFinish async_finish)
+{
+    WaitStats stats;
+    if (wait_for_cancellable_async_timed(budget, async_function, async_finish,
+        out stats))
+        return true;
+    fail_over_budget("Cancellable async operation", budget, stats);
+    return false;
+}
+}  // namespace Gt
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2026 The Gt authors
+ *
+ * This file is part of Gt.
+ *
+ * Gt is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * Gt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Gt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gt {
+/**
+ * What happens to data written to streams opened on a #GtMockFile.
+ *
+ * Every mode except %GT_MOCK_WRITE_MODE_STORE runs in constant memory, so it
+ * can be used to test or benchmark code that writes more data than fits in
+ * memory.
+ * Streams opened in those modes can't seek or truncate, the file's contents
+ * are empty after the stream is closed, and the data does not take up space
+ * on a #GtMockMount.
+ */
+public enum MockWriteMode {
+    /** Keep the data as the contents of the file; the default */
+    STORE,
+    /** Throw the data away, only counting the bytes */
+    DISCARD,
+    /**
+     * Throw the data away, only keeping its length and a running hash; the
+     * hash becomes the file's etag when the stream is closed
+     */
+    DIGEST,
+    /**
+     * Compare the data with the expected contents as it is written, and fail
+     * the write at the first byte that differs; see
+     * gt_mock_file_expect_contents()
+     */
+    EXPECT
+}
+
+/**
+ * Fills @buffer with the expected contents of a mock file starting at
+ * @offset.
+ * The generator must produce the same bytes every time it is asked for the
+ * same range.
+ *
+ * @param offset Offset in the file of the first byte of @buffer
+ * @param buffer Buffer to fill completely
+ */
+public delegate void MockContentGenerator(uint64 offset, uint8[] buffer);
+
+// Contents expected to be written to a mock file in MockWriteMode.EXPECT,
+// either held in a GBytes (which may come from a GMappedFile) or produced a
+// chunk at a time by a generator
+internal class ExpectedContents {
+    private Bytes? bytes;
+    private MockContentGenerator? generator;
+
+    public uint64 length { get; private set; }
+
+    public ExpectedContents.from_bytes(Bytes bytes) {
+        this.bytes = bytes;
+        length = bytes.get_size();
+    }
+
+    public ExpectedContents.from_generator(uint64 length,
+        owned MockContentGenerator generator)
+    {
+        this.generator = (owned) generator;
+        this.length = length;
+    }
+
+    // Returns the offset relative to @data of the first byte of @data that
+    // differs from the expected contents at @offset, or -1 if they all match.
+    // @scratch is used to hold generated contents.
+    public int64 compare(uint8[] data, uint64 offset, ref uint8[]? scratch) {
+        var overlap = (size_t) uint64.min(data.length,
+            offset < length ? length - offset : 0);
+        int64 retval = -1;
+        if (bytes != null) {
+            var expected = (uint8 *) bytes.get_data() + (size_t) offset;
+            retval = ContentCheck.find_mismatch(data, expected, overlap);
+        } else {
+            if (scratch == null)
+                scratch = new uint8[ContentCheck.CHUNK_SIZE];
+            for (size_t pos = 0; pos < overlap && retval == -1;
+                pos += scratch.length)
+            {
+                var n = size_t.min(scratch.length, overlap - pos);
+                generator(offset + pos, scratch[0:n]);
+                retval = ContentCheck.find_mismatch((uint8 *) data + pos,
+                    scratch, n);
+                if (retval != -1)
+                    retval += (int64) pos;
+            }
+        }
+        // Writing past the end of the expected contents is also a mismatch
+        if (retval == -1 && overlap < data.length)
+            retval = (int64) overlap;
+        return retval;
+    }
+}
+}  // namespace Gt
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2026 The Gt authors
+ *
+ * This file is part of Gt.
+ *
+ * Gt is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * Gt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Gt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <unistd.h>
+
+#include "gt.h"
+
+static void
+spin (volatile unsigned *counter)
+{
+  for (unsigned ix = 0; ix < 100; ix++)
+    (*counter)++;
+}
+
+/* Keep the tests short; the defaults are meant for real benchmarks */
+static GtBenchOptions *
+quick_options (void)
+{
+  return g_object_new (GT_TYPE_BENCH_OPTIONS,
+                       "warmup-time", (gint64) 1000,
+                       "sample-time", (gint64) 100,
+                       "measure-time", (gint64) 10000,
+                       NULL);
+}
+
+static void
+test_bench_statistics (void)
+{
+  volatile unsigned counter = 0;
+  GtBenchOptions *options = quick_options ();
+  g_object_set (options, "output", GT_BENCH_OUTPUT_YAML, NULL);
+  GtBenchResult *result = gt_bench_run ("spin", (GtBlock) spin,
+                                        (gpointer) &counter, options);
+
+  g_assert_cmpuint (gt_bench_result_get_n_samples (result), >=, 10);
+  g_assert_cmpuint (gt_bench_result_get_iterations_per_sample (result), >=, 1);
+  g_assert_cmpfloat (gt_bench_result_get_min (result), <=,
+                     gt_bench_result_get_median (result));
+  g_assert_cmpfloat (gt_bench_result_get_median (result), <=,
+                     gt_bench_result_get_p90 (result));
+  g_assert_cmpfloat (gt_bench_result_get_p90 (result), <=,
+                     gt_bench_result_get_p99 (result));
+  g_assert_cmpfloat (gt_bench_result_get_p99 (result), <=,
+                     gt_bench_result_get_max (result));
+  g_assert_cmpfloat (gt_bench_result_get_mad (result), >=, 0.0);
+  g_assert_cmpuint (counter, >, 0);
+
+  g_object_unref (result);
+  g_object_unref (options);
+}
+
+static void
+test_bench_baseline_regression (void)
+{
+  if (g_test_subprocess ())
+    {
+      volatile unsigned counter = 0;
+      GtBenchOptions *options = quick_options ();
+      g_object_set (options, "baseline-file", g_getenv ("GT_TEST_BASELINE"),
+                    NULL);
+      g_object_unref (gt_bench_run ("spin", (GtBlock) spin,
+                                    (gpointer) &counter, options));
+      g_object_unref (options);
+      return;
+    }
+
+  GError *error = NULL;
+  char *baseline;
+  int fd = g_file_open_tmp ("gt-baseline-XXXXXX", &baseline, &error);
+  g_assert_no_error (error);
+  close (fd);
+  /* Nothing is this fast */
+  g_assert_true (g_file_set_contents (baseline, "[spin]\nmedian=0.001\n", -1,
+                                      &error));
+  g_assert_no_error (error);
+
+  g_setenv ("GT_TEST_BASELINE", baseline, TRUE);
+  g_test_trap_subprocess (NULL, 0, 0);
+  g_test_trap_assert_failed ();
+  g_test_trap_assert_stdout ("*bench spin regressed*");
+
+  g_unlink (baseline);
+  g_free (baseline);
+}
+
+static void
+test_bench_update_baseline (void)
+{
+  GError *error = NULL;
+  char *baseline;
+  int fd = g_file_open_tmp ("gt-baseline-XXXXXX", &baseline, &error);
+  g_assert_no_error (error);
+  close (fd);
+
+  volatile unsigned counter = 0;
+  GtBenchOptions *options = quick_options ();
+  g_object_set (options, "baseline-file", baseline, "update-baseline", TRUE,
+                "output", GT_BENCH_OUTPUT_NONE, NULL);
+  GtBenchResult *result = gt_bench_run ("spin", (GtBlock) spin,
+                                        (gpointer) &counter, options);
+
+  GKeyFile *keyfile = g_key_file_new ();
+  g_assert_true (g_key_file_load_from_file (keyfile, baseline, G_KEY_FILE_NONE,
+                                            &error));
+  g_assert_no_error (error);
+  g_assert_cmpfloat (g_key_file_get_double (keyfile, "spin", "median", &error),
+                     ==, gt_bench_result_get_median (result));
+  g_assert_no_error (error);
+
+  g_key_file_unref (keyfile);
+  g_object_unref (result);
+  g_object_unref (options);
+  g_unlink (baseline);
+  g_free (baseline);
+}
+
+static void
+allocate_and_free (void)
+{
+  g_free (g_malloc (100));
+}
+
+static void
+do_nothing (void)
+{
+}
+
+static void
+test_bench_count_allocations (void)
+{
+  if (!gt_allocation_counting_available ())
+    {
+      g_test_skip ("Allocation counting shim is not loaded");
+      return;
+    }
+
+  GtAllocStats stats;
+  g_assert_true (gt_count_allocations ((GtBlock) allocate_and_free, NULL,
+                                       &stats));
+  g_assert_cmpuint (stats.n_allocations, ==, 1);
+  g_assert_cmpuint (stats.n_frees, ==, 1);
+  g_assert_cmpint (stats.net_bytes, ==, 0);
+  g_assert_cmpint (stats.peak_bytes, >=, 100);
+
+  g_assert_true (gt_assert_no_allocations (1, (GtBlock) do_nothing, NULL));
+}
+
+static void
+test_bench_allocations_over_limit (void)
+{
+  if (g_test_subprocess ())
+    {
+      gt_assert_no_allocations (1, (GtBlock) allocate_and_free, NULL);
+      return;
+    }
+  if (!gt_allocation_counting_available ())
+    {
+      g_test_skip ("Allocation counting shim is not loaded");
+      return;
+    }
+  g_test_trap_subprocess (NULL, 0, 0);
+  g_test_trap_assert_failed ();
+}
+
+static void
+sleep_briefly (void)
+{
+  g_usleep (1000);
+}
+
+static void
+test_bench_perf_counts (void)
+{
+  GtPerfCounts counts;
+  gt_measure_perf_counts (GT_PERF_SCOPE_THREAD, (GtBlock) sleep_briefly, NULL,
+                          &counts);
+  if (!counts.from_perf_events)
+    g_test_message ("perf events not available; used getrusage()");
+  /* Sleeping gives up the CPU */
+  g_assert_cmpuint (counts.context_switches, >=, 1);
+  g_assert_cmpuint (counts.major_faults, ==, 0);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/bench/statistics", test_bench_statistics);
+  g_test_add_func ("/bench/baseline/regression", test_bench_baseline_regression);
+  g_test_add_func ("/bench/baseline/update", test_bench_update_baseline);
+  g_test_add_func ("/bench/allocations/count", test_bench_count_allocations);
+  g_test_add_func ("/bench/allocations/over-limit",
+                   test_bench_allocations_over_limit);
+  g_test_add_func ("/bench/perf-counts", test_bench_perf_counts);
+
+  return g_test_run ();
+}
@@ -17,6 +17,10 @@
  */
 
 #include <gio/gio.h>
+#include <gio/gfiledescriptorbased.h>
+
+#include <string.h>
+#include <unistd.h>
 
 #include "gt.h"
 
@@ -168,6 +172,36 @@ test_mock_stores_contents_utf8 (Fixture      *fixture,
   g_assert_cmpstr (contents, ==, SAMPLE_UTF8_CONTENTS);
 }
 
+static void
+test_mock_contents_utf8_is_borrowed (Fixture      *fixture,
+                                     gconstpointer unused)
+{
+  GtMockFile *mock = GT_MOCK_FILE (fixture->file);
+  static const guint8 data[] = { 'a', 'b', 'c' };
+  GBytes *bytes = g_bytes_new_static (data, sizeof (data));
+  gt_mock_file_set_contents (mock, bytes);
+  g_bytes_unref (bytes);
+
+  /* The nul-terminated view is made once and reused */
+  const char *contents = gt_mock_file_get_contents_utf8 (mock);
+  g_assert_cmpstr (contents, ==, "abc");
+  g_assert_true (gt_mock_file_get_contents_utf8 (mock) == contents);
+  g_assert_true (gt_mock_file_get_contents_valid_utf8 (mock));
+
+  /* Contents set as a string are not copied when read back */
+  gt_mock_file_set_contents_utf8 (mock, SAMPLE_UTF8_CONTENTS);
+  contents = gt_mock_file_get_contents_utf8 (mock);
+  g_assert_cmpstr (contents, ==, SAMPLE_UTF8_CONTENTS);
+  g_assert_true (contents == g_bytes_get_data (gt_mock_file_get_contents (mock),
+                                               NULL));
+
+  static const guint8 invalid[] = { 0xff, 0xfe };
+  bytes = g_bytes_new_static (invalid, sizeof (invalid));
+  gt_mock_file_set_contents (mock, bytes);
+  g_bytes_unref (bytes);
+  g_assert_false (gt_mock_file_get_contents_valid_utf8 (mock));
+}
+
 static void
 test_mock_reads_contents (Fixture      *fixture,
                           gconstpointer unused)
@@ -215,6 +249,1412 @@ test_mock_writes_contents (void)
   g_object_unref (file);
 }
 
+static void
+test_mock_injects_fault_on_nth_call (Fixture      *fixture,
+                                     gconstpointer unused)
+{
+  GtFaultInjector *injector = gt_fault_injector_new (0);
+  gt_fault_injector_add_fault (injector, GT_MOCK_OPERATION_READ, NULL, 2,
+                               GT_MOCK_FAULT_BUSY);
+  gt_mock_file_set_fault_injector (GT_MOCK_FILE (fixture->file), injector);
+
+  GError *error = NULL;
+  GFileInputStream *istream = g_file_read (fixture->file, NULL, &error);
+  g_assert_no_error (error);
+  g_object_unref (istream);
+
+  istream = g_file_read (fixture->file, NULL, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_BUSY);
+  g_assert_null (istream);
+  g_clear_error (&error);
+
+  istream = g_file_read (fixture->file, NULL, &error);
+  g_assert_no_error (error);
+  g_object_unref (istream);
+
+  GVariant *schedule = gt_fault_injector_get_schedule (injector);
+  g_assert_cmpuint (g_variant_n_children (schedule), ==, 1);
+  guint64 call;
+  const char *operation, *path, *fault;
+  g_variant_get_child (schedule, 0, "(t&s&s&s)", &call, &operation, &path, &fault);
+  g_assert_cmpuint (call, ==, 2);
+  g_assert_cmpstr (operation, ==, "read");
+  g_assert_cmpstr (fault, ==, "busy");
+  g_variant_unref (schedule);
+
+  g_object_unref (injector);
+}
+
+static void
+test_mock_injects_fault_by_path_pattern (Fixture      *fixture,
+                                         gconstpointer unused)
+{
+  GtFaultInjector *injector = gt_fault_injector_new (0);
+  gt_fault_injector_add_fault (injector, GT_MOCK_OPERATION_QUERY_INFO,
+                               "*.log", 0, GT_MOCK_FAULT_PERMISSION_DENIED);
+  gt_mock_file_set_fault_injector (GT_MOCK_FILE (fixture->file), injector);
+  GFile *log = g_file_get_child (fixture->file, "out.log");
+  GFile *txt = g_file_get_child (fixture->file, "out.txt");
+
+  GError *error = NULL;
+  GFileInfo *info = g_file_query_info (log, "*", G_FILE_QUERY_INFO_NONE, NULL,
+                                       &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_PERMISSION_DENIED);
+  g_assert_null (info);
+  g_clear_error (&error);
+
+  info = g_file_query_info (txt, "*", G_FILE_QUERY_INFO_NONE, NULL, &error);
+  g_assert_no_error (error);
+  g_object_unref (info);
+
+  g_object_unref (log);
+  g_object_unref (txt);
+  g_object_unref (injector);
+}
+
+static GVariant *
+read_with_random_short_reads (GFile   *file,
+                              guint32  seed,
+                              gsize   *total_read)
+{
+  GtFaultInjector *injector = gt_fault_injector_new (seed);
+  gt_fault_injector_add_random_fault (injector, GT_MOCK_OPERATION_STREAM_READ,
+                                      NULL, 0.5, GT_MOCK_FAULT_SHORT_IO);
+  gt_mock_file_set_fault_injector (GT_MOCK_FILE (file), injector);
+
+  GError *error = NULL;
+  GFileInputStream *istream = g_file_read (file, NULL, &error);
+  g_assert_no_error (error);
+  char buffer[4];
+  gssize nread;
+  *total_read = 0;
+  while ((nread = g_input_stream_read (G_INPUT_STREAM (istream), buffer, 4,
+                                       NULL, &error)) > 0)
+    *total_read += nread;
+  g_assert_no_error (error);
+  g_object_unref (istream);
+
+  GVariant *schedule = gt_fault_injector_get_schedule (injector);
+  g_object_unref (injector);
+  return schedule;
+}
+
+static void
+test_mock_injects_reproducible_random_faults (Fixture      *fixture,
+                                              gconstpointer unused)
+{
+  gt_mock_file_set_contents_utf8 (GT_MOCK_FILE (fixture->file),
+                                  SAMPLE_UTF8_CONTENTS);
+  gsize total1, total2;
+  GVariant *schedule1 = read_with_random_short_reads (fixture->file, 42, &total1);
+  GVariant *schedule2 = read_with_random_short_reads (fixture->file, 42, &total2);
+
+  g_assert_cmpuint (total1, ==, strlen (SAMPLE_UTF8_CONTENTS));
+  g_assert_cmpuint (total2, ==, strlen (SAMPLE_UTF8_CONTENTS));
+  g_assert_cmpuint (g_variant_n_children (schedule1), >, 0);
+  g_assert_true (g_variant_equal (schedule1, schedule2));
+
+  g_variant_unref (schedule1);
+  g_variant_unref (schedule2);
+}
+
+static void
+test_mock_reads_one_byte_at_a_time (Fixture      *fixture,
+                                    gconstpointer unused)
+{
+  GtMockFile *mock = GT_MOCK_FILE (fixture->file);
+  gt_mock_file_set_contents_utf8 (mock, SAMPLE_UTF8_CONTENTS);
+  GtChunkPolicy *policy = gt_chunk_policy_new_fixed (1);
+  gt_mock_file_set_read_chunk_policy (mock, policy);
+  g_object_unref (policy);
+
+  GError *error = NULL;
+  GFileInputStream *istream = g_file_read (fixture->file, NULL, &error);
+  g_assert_no_error (error);
+  char buffer[64];
+  gsize total = 0;
+  g_assert_true (g_input_stream_read_all (G_INPUT_STREAM (istream), buffer,
+                                          sizeof (buffer), &total, NULL,
+                                          &error));
+  g_assert_no_error (error);
+  g_object_unref (istream);
+
+  g_assert_cmpuint (total, ==, strlen (SAMPLE_UTF8_CONTENTS));
+  /* One call per byte, plus one to read end-of-file */
+  g_assert_cmpuint (gt_mock_file_get_n_read_calls (mock), ==, total + 1);
+  g_assert_cmpuint (gt_mock_file_get_n_bytes_read (mock), ==, total);
+}
+
+static gpointer
+read_in_small_pieces (GInputStream *istream)
+{
+  char buffer[3];
+  GError *error = NULL;
+  while (g_input_stream_read (istream, buffer, sizeof buffer, NULL, &error) > 0)
+    ;
+  g_assert_no_error (error);
+  return NULL;
+}
+
+static void
+test_mock_counts_concurrent_reads (void)
+{
+  GtMockFile *mock = gt_mock_file_new ();
+  GBytes *contents = g_bytes_new_take (g_malloc0 (3000), 3000);
+  gt_mock_file_set_contents (mock, contents);
+  g_bytes_unref (contents);
+
+  GInputStream *streams[4];
+  GThread *threads[4];
+  GError *error = NULL;
+  for (int ix = 0; ix < 4; ix++)
+    {
+      streams[ix] = G_INPUT_STREAM (g_file_read (G_FILE (mock), NULL, &error));
+      g_assert_no_error (error);
+    }
+  for (int ix = 0; ix < 4; ix++)
+    threads[ix] = g_thread_new ("reader", (GThreadFunc) read_in_small_pieces,
+                                streams[ix]);
+  for (int ix = 0; ix < 4; ix++)
+    {
+      g_thread_join (threads[ix]);
+      g_object_unref (streams[ix]);
+    }
+
+  /* 1000 reads of 3 bytes each, plus one to read end-of-file, per stream */
+  g_assert_cmpuint (gt_mock_file_get_n_read_calls (mock), ==, 4 * 1001);
+  g_assert_cmpuint (gt_mock_file_get_n_bytes_read (mock), ==, 4 * 3000);
+  g_object_unref (mock);
+}
+
+static void
+test_mock_writes_in_chunk_sequence (void)
+{
+  GtMockFile *mock = GT_MOCK_FILE (g_object_new (GT_TYPE_MOCK_FILE,
+                                                 "exists", FALSE,
+                                                 NULL));
+  gsize sizes[] = { 3, 5 };
+  GtChunkPolicy *policy = gt_chunk_policy_new_sequence (sizes, 2);
+  gt_mock_file_set_write_chunk_policy (mock, policy);
+  g_object_unref (policy);
+
+  GError *error = NULL;
+  GFileOutputStream *ostream = g_file_create (G_FILE (mock), G_FILE_CREATE_NONE,
+                                              NULL, &error);
+  g_assert_no_error (error);
+  gssize nwritten = g_output_stream_write (G_OUTPUT_STREAM (ostream),
+                                           SAMPLE_UTF8_CONTENTS,
+                                           strlen (SAMPLE_UTF8_CONTENTS),
+                                           NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (nwritten, ==, 3);
+  g_assert_true (g_output_stream_write_all (G_OUTPUT_STREAM (ostream),
+                                            SAMPLE_UTF8_CONTENTS + 3,
+                                            strlen (SAMPLE_UTF8_CONTENTS) - 3,
+                                            NULL, NULL, &error));
+  g_assert_no_error (error);
+  g_assert_true (g_output_stream_close (G_OUTPUT_STREAM (ostream), NULL, &error));
+  g_assert_no_error (error);
+  g_object_unref (ostream);
+
+  /* 3 + 5 + 3 + 5 + 3 + 4 */
+  g_assert_cmpuint (gt_mock_file_get_n_write_calls (mock), ==, 6);
+  g_assert_cmpstr (gt_mock_file_get_contents_utf8 (mock), ==, SAMPLE_UTF8_CONTENTS);
+  g_object_unref (mock);
+}
+
+static void
+test_mock_mount_reports_filesystem_info (Fixture      *fixture,
+                                         gconstpointer unused)
+{
+  gt_mock_file_set_contents_utf8 (GT_MOCK_FILE (fixture->file),
+                                  SAMPLE_UTF8_CONTENTS);
+  GtMockMount *mount = gt_mock_mount_new (GT_MOCK_FILE (fixture->file), 100,
+                                          GT_MOCK_STORAGE_PROFILE_NFS);
+  GFile *child = g_file_get_child (fixture->file, "foobar");
+
+  GError *error = NULL;
+  GFileInfo *info = g_file_query_filesystem_info (child, "filesystem::*", NULL,
+                                                  &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_SIZE),
+                    ==, 100);
+  g_assert_cmpuint (g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_USED),
+                    ==, strlen (SAMPLE_UTF8_CONTENTS));
+  g_assert_cmpuint (g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE),
+                    ==, 100 - strlen (SAMPLE_UTF8_CONTENTS));
+  g_assert_cmpstr (g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_FILESYSTEM_TYPE),
+                   ==, "nfs");
+  g_assert_true (g_file_info_get_attribute_boolean (info, G_FILE_ATTRIBUTE_FILESYSTEM_REMOTE));
+  g_object_unref (info);
+
+  GMount *enclosing = g_file_find_enclosing_mount (child, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_true (enclosing == G_MOUNT (mount));
+  g_object_unref (enclosing);
+
+  g_object_unref (child);
+  g_object_unref (mount);
+}
+
+static void
+test_mock_mount_fills_up_at_exact_byte (void)
+{
+  GtMockFile *mock = GT_MOCK_FILE (g_object_new (GT_TYPE_MOCK_FILE,
+                                                 "exists", FALSE,
+                                                 NULL));
+  GtMockMount *mount = gt_mock_mount_new (mock, 10, GT_MOCK_STORAGE_PROFILE_TMPFS);
+
+  GError *error = NULL;
+  GFileOutputStream *ostream = g_file_create (G_FILE (mock), G_FILE_CREATE_NONE,
+                                              NULL, &error);
+  g_assert_no_error (error);
+  gssize nwritten = g_output_stream_write (G_OUTPUT_STREAM (ostream),
+                                           SAMPLE_UTF8_CONTENTS,
+                                           strlen (SAMPLE_UTF8_CONTENTS),
+                                           NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (nwritten, ==, 10);
+  g_assert_cmpuint (gt_mock_mount_get_used (mount), ==, 10);
+
+  nwritten = g_output_stream_write (G_OUTPUT_STREAM (ostream),
+                                    SAMPLE_UTF8_CONTENTS + 10, 1, NULL, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NO_SPACE);
+  g_assert_cmpint (nwritten, ==, -1);
+  g_clear_error (&error);
+
+  g_assert_true (g_output_stream_close (G_OUTPUT_STREAM (ostream), NULL, &error));
+  g_assert_no_error (error);
+  g_object_unref (ostream);
+
+  GBytes *contents = gt_mock_file_get_contents (mock);
+  g_assert_cmpuint (g_bytes_get_size (contents), ==, 10);
+  g_assert_cmpuint (gt_mock_mount_get_used (mount), ==, 10);
+
+  g_object_unref (mount);
+  g_object_unref (mock);
+}
+
+static void
+test_mock_mount_failed_close_releases_space (void)
+{
+  GtMockFile *mock = GT_MOCK_FILE (g_object_new (GT_TYPE_MOCK_FILE,
+                                                 "exists", FALSE,
+                                                 NULL));
+  GtMockMount *mount = gt_mock_mount_new (mock, 100, GT_MOCK_STORAGE_PROFILE_TMPFS);
+  GtFaultInjector *injector = gt_fault_injector_new (0);
+  gt_fault_injector_add_fault (injector, GT_MOCK_OPERATION_STREAM_CLOSE, NULL, 1,
+                               GT_MOCK_FAULT_BUSY);
+  gt_mock_file_set_fault_injector (mock, injector);
+
+  GError *error = NULL;
+  GFileOutputStream *ostream = g_file_create (G_FILE (mock), G_FILE_CREATE_NONE,
+                                              NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (g_output_stream_write (G_OUTPUT_STREAM (ostream),
+                                          SAMPLE_UTF8_CONTENTS, 10, NULL, &error),
+                   ==, 10);
+  g_assert_no_error (error);
+  g_assert_cmpuint (gt_mock_mount_get_used (mount), ==, 10);
+
+  g_assert_false (g_output_stream_close (G_OUTPUT_STREAM (ostream), NULL, &error));
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_BUSY);
+  g_clear_error (&error);
+  g_object_unref (ostream);
+
+  /* The data was never stored, so the space it reserved is free again */
+  g_assert_cmpuint (gt_mock_mount_get_used (mount), ==, 0);
+
+  g_object_unref (injector);
+  g_object_unref (mount);
+  g_object_unref (mock);
+}
+
+static gpointer
+fill_mount (GOutputStream *ostream)
+{
+  GError *error = NULL;
+  gsize total = 0;
+  while (g_output_stream_write (ostream, "o", 1, NULL, &error) == 1)
+    total++;
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NO_SPACE);
+  g_clear_error (&error);
+  return GSIZE_TO_POINTER (total);
+}
+
+static void
+test_mock_mount_concurrent_writers_share_space (void)
+{
+  GtMockFile *root = gt_mock_file_new ();
+  GtMockMount *mount = gt_mock_mount_new (root, 1000, GT_MOCK_STORAGE_PROFILE_TMPFS);
+  GFile *files[4];
+  GFileOutputStream *streams[4];
+  GThread *threads[4];
+  GError *error = NULL;
+  /* Only the writes happen on several threads; the tree is set up first */
+  for (int ix = 0; ix < 4; ix++)
+    {
+      char *name = g_strdup_printf ("%d", ix);
+      files[ix] = g_file_get_child (G_FILE (root), name);
+      g_free (name);
+      streams[ix] = g_file_replace (files[ix], NULL, FALSE, G_FILE_CREATE_NONE,
+                                    NULL, &error);
+      g_assert_no_error (error);
+    }
+  for (int ix = 0; ix < 4; ix++)
+    threads[ix] = g_thread_new ("writer", (GThreadFunc) fill_mount, streams[ix]);
+
+  /* Every byte of the capacity went to exactly one writer */
+  gsize total = 0;
+  for (int ix = 0; ix < 4; ix++)
+    total += GPOINTER_TO_SIZE (g_thread_join (threads[ix]));
+  g_assert_cmpuint (total, ==, 1000);
+  g_assert_cmpuint (gt_mock_mount_get_used (mount), ==, 1000);
+
+  for (int ix = 0; ix < 4; ix++)
+    {
+      g_assert_true (g_output_stream_close (G_OUTPUT_STREAM (streams[ix]),
+                                            NULL, &error));
+      g_assert_no_error (error);
+      g_object_unref (streams[ix]);
+      g_object_unref (files[ix]);
+    }
+  g_assert_cmpuint (gt_mock_mount_get_used (mount), ==, 1000);
+  g_object_unref (mount);
+  g_object_unref (root);
+}
+
+static void
+replace_contents (GFile      *file,
+                  const char *contents,
+                  const char *etag,
+                  char      **new_etag,
+                  GError    **error)
+{
+  g_file_replace_contents (file, contents, strlen (contents), etag, FALSE,
+                           G_FILE_CREATE_NONE, new_etag, NULL, error);
+}
+
+static void
+test_mock_etag_follows_contents (Fixture      *fixture,
+                                 gconstpointer unused)
+{
+  GtMockFile *mock = GT_MOCK_FILE (fixture->file);
+  gt_mock_file_set_contents_utf8 (mock, SAMPLE_UTF8_CONTENTS);
+  char *etag1 = g_strdup (gt_mock_file_get_etag (mock));
+  g_assert_cmpstr (etag1, !=, "");
+
+  /* Same contents written through a stream produce the same etag */
+  GError *error = NULL;
+  char *etag2 = NULL;
+  replace_contents (fixture->file, SAMPLE_UTF8_CONTENTS, NULL, &etag2, &error);
+  g_assert_no_error (error);
+  g_assert_cmpstr (etag1, ==, etag2);
+
+  GFileInfo *info = g_file_query_info (fixture->file, G_FILE_ATTRIBUTE_ETAG_VALUE,
+                                       G_FILE_QUERY_INFO_NONE, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpstr (g_file_info_get_etag (info), ==, etag1);
+  g_object_unref (info);
+
+  gt_mock_file_set_contents_utf8 (mock, "foobar");
+  g_assert_cmpstr (gt_mock_file_get_etag (mock), !=, etag1);
+
+  g_free (etag1);
+  g_free (etag2);
+}
+
+static void
+test_mock_replace_detects_wrong_etag (Fixture      *fixture,
+                                      gconstpointer unused)
+{
+  GtMockFile *mock = GT_MOCK_FILE (fixture->file);
+  gt_mock_file_set_contents_utf8 (mock, SAMPLE_UTF8_CONTENTS);
+  char *etag = g_strdup (gt_mock_file_get_etag (mock));
+
+  /* Someone else changes the file in the meantime */
+  gt_mock_file_set_contents_utf8 (mock, "foobar");
+
+  GError *error = NULL;
+  replace_contents (fixture->file, "baz", etag, NULL, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_WRONG_ETAG);
+  g_clear_error (&error);
+  g_assert_cmpstr (gt_mock_file_get_contents_utf8 (mock), ==, "foobar");
+
+  replace_contents (fixture->file, "baz", gt_mock_file_get_etag (mock), NULL,
+                    &error);
+  g_assert_no_error (error);
+  g_assert_cmpstr (gt_mock_file_get_contents_utf8 (mock), ==, "baz");
+
+  g_free (etag);
+}
+
+static void
+test_mock_query_info_standard_attributes (Fixture      *fixture,
+                                          gconstpointer unused)
+{
+  GFile *child = g_file_get_child (fixture->file, "notes.txt");
+  gt_mock_file_set_contents_utf8 (GT_MOCK_FILE (child), SAMPLE_UTF8_CONTENTS);
+
+  GError *error = NULL;
+  GFileInfo *info = g_file_query_info (child, "standard::*,time::modified",
+                                       G_FILE_QUERY_INFO_NONE, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpstr (g_file_info_get_name (info), ==, "notes.txt");
+  g_assert_cmpint (g_file_info_get_size (info), ==, strlen (SAMPLE_UTF8_CONTENTS));
+  g_assert_cmpuint (g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_STANDARD_ALLOCATED_SIZE),
+                    ==, 4096);
+  g_assert_true (g_content_type_is_a (g_file_info_get_content_type (info), "text/plain"));
+  g_assert_false (g_file_info_get_is_hidden (info));
+  g_assert_true (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_TIME_MODIFIED));
+  /* Attributes that weren't asked for are not returned */
+  g_assert_false (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_ETAG_VALUE));
+  g_assert_false (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_ID_FILE));
+  g_object_unref (info);
+
+  /* Changing the contents updates the info */
+  gt_mock_file_set_contents_utf8 (GT_MOCK_FILE (child), "foobar");
+  info = g_file_query_info (child, G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                            G_FILE_QUERY_INFO_NONE, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (g_file_info_get_size (info), ==, strlen ("foobar"));
+  g_object_unref (info);
+
+  g_object_unref (child);
+}
+
+static void
+test_mock_measures_disk_usage_of_subtree (Fixture      *fixture,
+                                          gconstpointer unused)
+{
+  GFile *a = g_file_get_child (fixture->file, "a");
+  GFile *c = g_file_resolve_relative_path (fixture->file, "b/c");
+  gt_mock_file_set_contents_utf8 (GT_MOCK_FILE (a), "0123456789");
+  gt_mock_file_set_contents_utf8 (GT_MOCK_FILE (c), "01234");
+
+  GError *error = NULL;
+  guint64 disk_usage, num_dirs, num_files;
+  g_assert_true (g_file_measure_disk_usage (fixture->file,
+                                            G_FILE_MEASURE_APPARENT_SIZE, NULL,
+                                            NULL, NULL, &disk_usage, &num_dirs,
+                                            &num_files, &error));
+  g_assert_no_error (error);
+  g_assert_cmpuint (disk_usage, ==, 15);
+  g_assert_cmpuint (num_dirs, ==, 2);
+  g_assert_cmpuint (num_files, ==, 2);
+
+  g_assert_true (g_file_measure_disk_usage (fixture->file,
+                                            G_FILE_MEASURE_NONE, NULL, NULL,
+                                            NULL, &disk_usage, NULL, NULL,
+                                            &error));
+  g_assert_no_error (error);
+  g_assert_cmpuint (disk_usage, ==, 8192);
+
+  /* Totals follow changes anywhere in the subtree */
+  gt_mock_file_set_contents_utf8 (GT_MOCK_FILE (c), "");
+  g_assert_true (g_file_measure_disk_usage (fixture->file,
+                                            G_FILE_MEASURE_APPARENT_SIZE, NULL,
+                                            NULL, NULL, &disk_usage, &num_dirs,
+                                            &num_files, &error));
+  g_assert_no_error (error);
+  g_assert_cmpuint (disk_usage, ==, 10);
+  g_assert_cmpuint (num_dirs, ==, 2);
+  g_assert_cmpuint (num_files, ==, 2);
+
+  g_object_unref (a);
+  g_object_unref (c);
+}
+
+static void
+test_mock_content_assertions (Fixture      *fixture,
+                              gconstpointer unused)
+{
+  GtMockFile *mock = GT_MOCK_FILE (fixture->file);
+  gt_mock_file_set_contents_utf8 (mock, "owl owl owl owl owl");
+
+  gint64 offset;
+  GBytes *expected = g_bytes_new_static ("owl owl owl owl owl", 19);
+  g_assert_true (gt_mock_file_assert_contents_equal (mock, expected, &offset));
+  g_assert_cmpint (offset, ==, -1);
+  g_bytes_unref (expected);
+
+  GtMockFile *other = gt_mock_file_new ();
+  gt_mock_file_set_contents_utf8 (other, "owl owl owl owl owl");
+  g_assert_true (gt_mock_file_assert_contents_equal_mock (mock, other, NULL));
+  g_object_unref (other);
+
+  GError *error = NULL;
+  GFileIOStream *iostream;
+  GFile *golden = g_file_new_tmp ("gt-golden-XXXXXX", &iostream, &error);
+  g_assert_no_error (error);
+  g_object_unref (iostream);
+  g_assert_true (g_file_replace_contents (golden, "owl owl owl owl owl", 19,
+                                          NULL, FALSE, G_FILE_CREATE_NONE,
+                                          NULL, NULL, &error));
+  g_assert_no_error (error);
+  g_assert_true (gt_mock_file_assert_contents_equal_file (mock, golden,
+                                                          &offset, NULL,
+                                                          &error));
+  g_assert_no_error (error);
+  g_assert_cmpint (offset, ==, -1);
+  g_file_delete (golden, NULL, NULL);
+  g_object_unref (golden);
+
+  g_assert_cmpint (gt_mock_file_find_in_contents (mock, (guint8 *) "owl", 3, 1),
+                   ==, 4);
+  g_assert_cmpint (gt_mock_file_find_in_contents (mock, (guint8 *) "cat", 3, 0),
+                   ==, -1);
+  g_assert_cmpuint (gt_mock_file_count_in_contents (mock, (guint8 *) "owl", 3),
+                    ==, 5);
+
+  GRegex *regex = g_regex_new ("^owl( owl)+$", 0, 0, NULL);
+  g_assert_true (gt_mock_file_assert_contents_match (mock, regex, 0, -1));
+  g_assert_true (gt_mock_file_assert_contents_match (mock, regex, 4, 11));
+  g_regex_unref (regex);
+
+  /* Empty contents have no data, but still match an empty pattern */
+  GBytes *empty = g_bytes_new (NULL, 0);
+  gt_mock_file_set_contents (mock, empty);
+  g_bytes_unref (empty);
+  regex = g_regex_new ("^$", 0, 0, NULL);
+  g_assert_true (gt_mock_file_assert_contents_match (mock, regex, 0, -1));
+  g_regex_unref (regex);
+}
+
+static void
+test_mock_content_assertion_fails_on_mismatch (void)
+{
+  if (g_test_subprocess ())
+    {
+      GtMockFile *mock = gt_mock_file_new ();
+      gt_mock_file_set_contents_utf8 (mock, "owl owl owl");
+      GBytes *expected = g_bytes_new_static ("owl cat owl", 11);
+      gint64 offset;
+      g_assert_false (gt_mock_file_assert_contents_equal (mock, expected,
+                                                          &offset));
+      g_assert_cmpint (offset, ==, 4);
+      g_bytes_unref (expected);
+      g_object_unref (mock);
+      return;
+    }
+  g_test_trap_subprocess (NULL, 0, 0);
+  g_test_trap_assert_failed ();
+}
+
+static void
+generate_owls (guint64  offset,
+               guint8  *buffer,
+               int      buffer_length,
+               gpointer unused)
+{
+  for (int ix = 0; ix < buffer_length; ix++)
+    buffer[ix] = "owl "[(offset + ix) % 4];
+}
+
+static void
+record_etag (GtMockFile  *mock,
+             GParamSpec  *pspec,
+             char       **etag)
+{
+  g_free (*etag);
+  *etag = g_strdup (gt_mock_file_get_etag (mock));
+}
+
+static void
+test_mock_write_modes_do_not_store (Fixture      *fixture,
+                                    gconstpointer unused)
+{
+  GtMockFile *mock = GT_MOCK_FILE (fixture->file);
+  gt_mock_file_set_contents_utf8 (mock, "owl owl owl");
+  char *stored_etag = g_strdup (gt_mock_file_get_etag (mock));
+
+  /* Digest mode keeps only the hash, which becomes the etag */
+  gt_mock_file_set_write_mode (mock, GT_MOCK_WRITE_MODE_DIGEST);
+  GError *error = NULL;
+  char *etag = NULL;
+  char *notified_etag = NULL;
+  gulong id = g_signal_connect (mock, "notify::contents",
+                                G_CALLBACK (record_etag), &notified_etag);
+  replace_contents (fixture->file, "owl owl owl", NULL, &etag, &error);
+  g_assert_no_error (error);
+  g_signal_handler_disconnect (mock, id);
+  g_assert_cmpstr (etag, ==, stored_etag);
+  /* The etag is already the digest when the change is announced */
+  g_assert_cmpstr (notified_etag, ==, stored_etag);
+  g_assert_cmpuint (g_bytes_get_size (gt_mock_file_get_contents (mock)), ==, 0);
+  g_assert_cmpuint (gt_mock_file_get_n_bytes_written (mock), ==, 11);
+  /* The length and digest outlive the I/O counters */
+  gt_mock_file_reset_io_counters (mock);
+  g_assert_cmpuint (gt_mock_file_get_written_length (mock), ==, 11);
+  g_assert_cmpstr (gt_mock_file_get_written_digest (mock), ==, stored_etag);
+  g_free (notified_etag);
+  g_free (etag);
+  g_free (stored_etag);
+
+  /* Expect mode fails at the first byte that differs */
+  GBytes *expected = g_bytes_new_static ("owl owl owl", 11);
+  gt_mock_file_expect_contents (mock, expected);
+  g_bytes_unref (expected);
+  replace_contents (fixture->file, "owl owl owl", NULL, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (gt_mock_file_get_expectation_mismatch_offset (mock), ==, -1);
+  replace_contents (fixture->file, "owl cat owl", NULL, NULL, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+  g_clear_error (&error);
+  g_assert_cmpint (gt_mock_file_get_expectation_mismatch_offset (mock), ==, 4);
+
+  /* A generator can produce expected contents longer than fit in memory */
+  gt_mock_file_expect_generated_contents (mock, 12, generate_owls, NULL, NULL);
+  replace_contents (fixture->file, "owl owl owl ", NULL, NULL, &error);
+  g_assert_no_error (error);
+  replace_contents (fixture->file, "owl owl", NULL, NULL, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+  g_clear_error (&error);
+  g_assert_cmpint (gt_mock_file_get_expectation_mismatch_offset (mock), ==, 7);
+}
+
+static gboolean
+set_flag (GObject *pollable_stream,
+          gboolean *flag)
+{
+  *flag = TRUE;
+  return G_SOURCE_REMOVE;
+}
+
+static void
+test_mock_pollable_read_waits_for_writer (Fixture      *fixture,
+                                          gconstpointer unused)
+{
+  GtMockFile *mock = GT_MOCK_FILE (fixture->file);
+  gt_mock_file_set_contents_utf8 (mock, "owl");
+
+  GError *error = NULL;
+  GFileOutputStream *ostream = g_file_replace (fixture->file, NULL, FALSE,
+                                               G_FILE_CREATE_NONE, NULL, &error);
+  g_assert_no_error (error);
+  GFileInputStream *istream = g_file_read (fixture->file, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_true (G_IS_POLLABLE_INPUT_STREAM (istream));
+  GPollableInputStream *pollable = G_POLLABLE_INPUT_STREAM (istream);
+
+  char buffer[16];
+  g_assert_true (g_pollable_input_stream_is_readable (pollable));
+  g_assert_cmpint (g_pollable_input_stream_read_nonblocking (pollable, buffer,
+                                                              sizeof (buffer),
+                                                              NULL, &error),
+                   ==, 3);
+  g_assert_no_error (error);
+
+  /* The writer is still open, so more data may come */
+  g_assert_false (g_pollable_input_stream_is_readable (pollable));
+  g_pollable_input_stream_read_nonblocking (pollable, buffer, sizeof (buffer),
+                                            NULL, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK);
+  g_clear_error (&error);
+
+  gboolean readable = FALSE;
+  GSource *source = g_pollable_input_stream_create_source (pollable, NULL);
+  g_source_set_callback (source, (GSourceFunc) set_flag, &readable, NULL);
+  g_source_attach (source, NULL);
+  g_main_context_iteration (NULL, FALSE);
+  g_assert_false (readable);
+
+  g_assert_true (g_output_stream_write_all (G_OUTPUT_STREAM (ostream),
+                                            "owl owl", 7, NULL, NULL, &error));
+  g_assert_true (g_output_stream_close (G_OUTPUT_STREAM (ostream), NULL, &error));
+  g_assert_no_error (error);
+  while (!readable)
+    g_main_context_iteration (NULL, TRUE);
+  g_source_unref (source);
+
+  gssize nread = g_pollable_input_stream_read_nonblocking (pollable, buffer,
+                                                            sizeof (buffer),
+                                                            NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (nread, ==, 4);
+  g_assert_cmpint (memcmp (buffer, " owl", 4), ==, 0);
+
+  g_object_unref (istream);
+  g_object_unref (ostream);
+}
+
+static void
+test_mock_memfd_storage_exposes_fd (Fixture      *fixture,
+                                    gconstpointer unused)
+{
+  GtMockFile *mock = GT_MOCK_FILE (fixture->file);
+  gt_mock_file_set_storage (mock, GT_MOCK_FILE_STORAGE_MEMFD);
+
+  GError *error = NULL;
+  GFileOutputStream *ostream = g_file_replace (fixture->file, NULL, FALSE,
+                                               G_FILE_CREATE_NONE, NULL, &error);
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED))
+    {
+      g_test_skip ("memfd_create() is not available");
+      g_clear_error (&error);
+      return;
+    }
+  g_assert_no_error (error);
+  g_assert_true (G_IS_FILE_DESCRIPTOR_BASED (ostream));
+  int fd = g_file_descriptor_based_get_fd (G_FILE_DESCRIPTOR_BASED (ostream));
+  g_assert_cmpint (write (fd, "owl ", 4), ==, 4);
+  g_assert_true (g_output_stream_write_all (G_OUTPUT_STREAM (ostream), "owl", 3,
+                                            NULL, NULL, &error));
+  g_assert_true (g_output_stream_close (G_OUTPUT_STREAM (ostream), NULL, &error));
+  g_assert_no_error (error);
+  g_object_unref (ostream);
+
+  GBytes *contents = gt_mock_file_get_contents (mock);
+  g_assert_cmpuint (g_bytes_get_size (contents), ==, 7);
+  g_assert_cmpint (memcmp (g_bytes_get_data (contents, NULL), "owl owl", 7), ==, 0);
+
+  GFileInputStream *istream = g_file_read (fixture->file, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_true (G_IS_FILE_DESCRIPTOR_BASED (istream));
+  fd = g_file_descriptor_based_get_fd (G_FILE_DESCRIPTOR_BASED (istream));
+  char buffer[8];
+  g_assert_cmpint (read (fd, buffer, 4), ==, 4);
+  /* The stream and its file descriptor share a position */
+  g_assert_cmpint (g_seekable_tell (G_SEEKABLE (istream)), ==, 4);
+  g_assert_cmpint (g_input_stream_read (G_INPUT_STREAM (istream), buffer,
+                                        sizeof (buffer), NULL, &error), ==, 3);
+  g_assert_no_error (error);
+  g_assert_cmpint (memcmp (buffer, "owl", 3), ==, 0);
+  g_object_unref (istream);
+}
+
+static void
+test_mock_arena_shares_files (void)
+{
+  GError *error = NULL;
+  GtMockArena *arena = gt_mock_arena_new (1024 * 1024, 16, &error);
+  g_assert_no_error (error);
+
+  /* Another process would attach to the arena from its file descriptor and
+  open the file from its URI */
+  GtMockArena *other_arena = gt_mock_arena_new_attach (dup (gt_mock_arena_get_fd (arena)),
+                                                       &error);
+  g_assert_no_error (error);
+  GtMockFile *mock = gt_mock_file_new_with_id ("shared");
+  gt_mock_file_set_arena (mock, arena);
+  GtMockFile *other = gt_mock_file_new_with_id ("shared");
+  gt_mock_file_set_arena (other, other_arena);
+
+  gt_mock_file_set_contents_utf8 (mock, "owl owl");
+  g_assert_cmpstr (gt_mock_file_get_contents_utf8 (other), ==, "owl owl");
+
+  g_object_unref (mock);
+  g_object_unref (other);
+  g_object_unref (arena);
+  g_object_unref (other_arena);
+}
+
+static void
+test_mock_arena_rejects_bad_layout (void)
+{
+  GError *error = NULL;
+  GtMockArena *arena = gt_mock_arena_new (4096, 0, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT);
+  g_assert_null (arena);
+  g_clear_error (&error);
+
+  arena = gt_mock_arena_new (4096, 4, &error);
+  g_assert_no_error (error);
+  /* Claim more slots than fit; n_slots follows the 32-bit magic number */
+  guint32 n_slots = 1000;
+  g_assert_cmpint (pwrite (gt_mock_arena_get_fd (arena), &n_slots,
+                           sizeof n_slots, 4), ==, sizeof n_slots);
+  GtMockArena *other_arena = gt_mock_arena_new_attach (dup (gt_mock_arena_get_fd (arena)),
+                                                       &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+  g_assert_null (other_arena);
+  g_clear_error (&error);
+
+  g_object_unref (arena);
+}
+
+static void
+test_mock_arena_reclaims_space (void)
+{
+  GError *error = NULL;
+  GtMockArena *arena = gt_mock_arena_new (4096, 4, &error);
+  g_assert_no_error (error);
+  GtMockArena *other_arena = gt_mock_arena_new_attach (dup (gt_mock_arena_get_fd (arena)),
+                                                       &error);
+  g_assert_no_error (error);
+  GtMockFile *mock = gt_mock_file_new_with_id ("rewritten");
+  gt_mock_file_set_arena (mock, arena);
+  GtMockFile *other = gt_mock_file_new_with_id ("rewritten");
+  gt_mock_file_set_arena (other, other_arena);
+
+  /* Much more than the arena holds in total, but never more at once */
+  char data[200];
+  for (int ix = 0; ix < 100; ix++)
+    {
+      memset (data, 'a' + ix % 26, sizeof data);
+      GBytes *contents = g_bytes_new (data, sizeof data);
+      gt_mock_file_set_contents (mock, contents);
+      g_bytes_unref (contents);
+      GBytes *seen = gt_mock_file_get_contents (other);
+      g_assert_cmpmem (g_bytes_get_data (seen, NULL), g_bytes_get_size (seen),
+                       data, sizeof data);
+    }
+
+  /* Contents that don't fit at all are kept locally, without failing */
+  GBytes *huge = g_bytes_new_take (g_malloc0 (8192), 8192);
+  gt_mock_file_set_contents (mock, huge);
+  g_assert_cmpuint (g_bytes_get_size (gt_mock_file_get_contents (mock)), ==, 8192);
+  g_assert_cmpuint (g_bytes_get_size (gt_mock_file_get_contents (other)), ==, 200);
+  g_bytes_unref (huge);
+
+  g_object_unref (mock);
+  g_object_unref (other);
+  g_object_unref (arena);
+  g_object_unref (other_arena);
+}
+
+static void
+test_mock_dump_round_trip (void)
+{
+  GtMockFile *root = gt_mock_file_new_with_id ("root");
+  GFile *a = g_file_resolve_relative_path (G_FILE (root), "a");
+  GFile *b = g_file_resolve_relative_path (G_FILE (root), "dir/b");
+  GFile *c = g_file_resolve_relative_path (G_FILE (root), "dir/c");
+  /* Identical contents are only stored once */
+  char *big = g_strnfill (65536, 'o');
+  gt_mock_file_set_contents_utf8 (GT_MOCK_FILE (a), big);
+  gt_mock_file_set_contents_utf8 (GT_MOCK_FILE (b), big);
+  gt_mock_file_set_contents_utf8 (GT_MOCK_FILE (c), "owl");
+  g_free (big);
+
+  GError *error = NULL;
+  GFileIOStream *iostream;
+  GFile *dump = g_file_new_tmp ("gt-dump-XXXXXX", &iostream, &error);
+  g_assert_no_error (error);
+  g_object_unref (iostream);
+  gt_mock_file_dump (root, dump, NULL, &error);
+  g_assert_no_error (error);
+  GFileInfo *info = g_file_query_info (dump, G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                       G_FILE_QUERY_INFO_NONE, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (g_file_info_get_size (info), <, 2 * 65536);
+  g_object_unref (info);
+
+  GtMockFile *loaded = gt_mock_file_load (dump, NULL, &error);
+  g_assert_no_error (error);
+  GFile *loaded_a = g_file_get_child (G_FILE (loaded), "a");
+  GFile *loaded_c = g_file_resolve_relative_path (G_FILE (loaded), "dir/c");
+  g_assert_true (g_file_equal (loaded_a, a));
+  g_assert_true (gt_mock_file_assert_contents_equal_mock (GT_MOCK_FILE (loaded_a),
+                                                          GT_MOCK_FILE (a),
+                                                          NULL));
+  g_assert_cmpstr (gt_mock_file_get_contents_utf8 (GT_MOCK_FILE (loaded_c)),
+                   ==, "owl");
+  char *path = g_file_get_relative_path (G_FILE (loaded), loaded_c);
+  g_assert_cmpstr (path, ==, "dir/c");
+  g_free (path);
+
+  g_file_delete (dump, NULL, NULL);
+  g_object_unref (dump);
+  g_object_unref (loaded_a);
+  g_object_unref (loaded_c);
+  g_object_unref (loaded);
+  g_object_unref (a);
+  g_object_unref (b);
+  g_object_unref (c);
+  g_object_unref (root);
+}
+
+/* Writes a dump of the given nodes by hand, with one empty blob */
+static GFile *
+write_dump (const char *nodes)
+{
+  GVariant *metadata = g_variant_new_parsed ("(%@a(imssbuxxuutt), [(@t 0, @t 0)])",
+                                             g_variant_new_parsed (nodes));
+  gsize size = g_variant_get_size (metadata);
+  guint64 size_le = GUINT64_TO_LE ((guint64) size);
+  GByteArray *dump = g_byte_array_new ();
+  g_byte_array_append (dump, (const guint8 *) "GTDUMP\0\1", 8);
+  g_byte_array_append (dump, (const guint8 *) &size_le, 8);
+  g_byte_array_append (dump, g_variant_get_data (metadata), size);
+  g_variant_unref (g_variant_ref_sink (metadata));
+
+  GError *error = NULL;
+  GFileIOStream *iostream;
+  GFile *file = g_file_new_tmp ("gt-dump-XXXXXX", &iostream, &error);
+  g_assert_no_error (error);
+  g_object_unref (iostream);
+  g_file_replace_contents (file, (const char *) dump->data, dump->len, NULL,
+                           FALSE, G_FILE_CREATE_NONE, NULL, NULL, &error);
+  g_assert_no_error (error);
+  g_byte_array_unref (dump);
+  return file;
+}
+
+static void
+test_mock_dump_rejects_bad_names (void)
+{
+#define NODE(parent, name, id) \
+  "(" #parent ", " name ", '" id "', true, @u 0, @x 0, @x 0, @u 0, @u 0, @t 0, @t 0)"
+  const char *corrupt[] = {
+    /* A file other than the root without a name */
+    "[" NODE (-1, "@ms nothing", "root") ", " NODE (0, "@ms nothing", "a") "]",
+    /* Two siblings with the same name */
+    "[" NODE (-1, "@ms nothing", "root") ", " NODE (0, "@ms 'a'", "a") ", "
+    NODE (0, "@ms 'a'", "b") "]",
+  };
+#undef NODE
+
+  for (size_t ix = 0; ix < G_N_ELEMENTS (corrupt); ix++)
+    {
+      GFile *dump = write_dump (corrupt[ix]);
+      GError *error = NULL;
+      GtMockFile *loaded = gt_mock_file_load (dump, NULL, &error);
+      g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+      g_assert_null (loaded);
+      g_clear_error (&error);
+      g_file_delete (dump, NULL, NULL);
+      g_object_unref (dump);
+    }
+}
+
+static void
+test_mock_filesystem_frees_tree (void)
+{
+  GtMockFilesystem *fs = gt_mock_filesystem_new ();
+  GtMockFile *file = gt_mock_filesystem_get_file (fs, "a/b/c");
+  gt_mock_file_set_contents_utf8 (file, "owl");
+  GFile *parent = g_file_get_parent (G_FILE (file));
+  g_assert_cmpuint (gt_mock_filesystem_get_n_files (fs), ==, 4);
+  g_object_add_weak_pointer (G_OBJECT (parent), (gpointer *) &parent);
+  g_object_unref (parent);
+  g_assert_nonnull (parent);  /* still owned by the tree */
+
+  gt_mock_filesystem_clear (fs);
+  g_assert_null (parent);
+  g_assert_cmpuint (gt_mock_filesystem_get_n_files (fs), ==, 1);
+  /* Files that the test still holds stay usable */
+  g_assert_cmpstr (gt_mock_file_get_contents_utf8 (file), ==, "owl");
+
+  g_object_add_weak_pointer (G_OBJECT (file), (gpointer *) &file);
+  g_object_unref (file);
+  g_assert_null (file);
+  g_object_unref (fs);
+}
+
+static void
+test_mock_filesystem_clear_resets_usage (void)
+{
+  GtMockFilesystem *fs = gt_mock_filesystem_new ();
+  GtMockFile *dir = gt_mock_filesystem_get_file (fs, "dir");
+  GtMockMount *mount = gt_mock_mount_new (dir, 0, GT_MOCK_STORAGE_PROFILE_TMPFS);
+  GtMockFile *file = gt_mock_filesystem_get_file (fs, "dir/a");
+  gt_mock_file_set_contents_utf8 (file, "owl");
+  g_assert_cmpuint (gt_mock_mount_get_used (mount), ==, 3);
+
+  gt_mock_filesystem_clear (fs);
+  /* The files that the test still holds no longer count each other */
+  g_assert_cmpuint (gt_mock_mount_get_used (mount), ==, 0);
+  GError *error = NULL;
+  guint64 disk_usage, num_dirs, num_files;
+  g_assert_true (g_file_measure_disk_usage (G_FILE (dir),
+                                            G_FILE_MEASURE_APPARENT_SIZE,
+                                            NULL, NULL, NULL, &disk_usage,
+                                            &num_dirs, &num_files, &error));
+  g_assert_no_error (error);
+  g_assert_cmpuint (disk_usage, ==, 0);
+  g_assert_cmpuint (num_dirs, ==, 0);
+  g_assert_cmpuint (num_files, ==, 1);
+
+  g_object_unref (file);
+  g_object_unref (mount);
+  g_object_unref (dir);
+  g_object_unref (fs);
+}
+
+static void
+test_mock_memory_report (void)
+{
+  GtMockFile *root = gt_mock_file_new ();
+  GFile *a = g_file_resolve_relative_path (G_FILE (root), "dir/a");
+  GFile *b = g_file_resolve_relative_path (G_FILE (root), "dir/b");
+  GBytes *shared = g_bytes_new_static ("owl owl owl", 11);
+  gt_mock_file_set_contents (GT_MOCK_FILE (a), shared);
+  gt_mock_file_set_contents (GT_MOCK_FILE (b), shared);
+  g_bytes_unref (shared);
+
+  GError *error = NULL;
+  GFile *c = g_file_get_child (G_FILE (root), "c");
+  GFileOutputStream *stream = g_file_replace (c, NULL, FALSE,
+                                              G_FILE_CREATE_NONE, NULL, &error);
+  g_assert_no_error (error);
+  g_output_stream_write_all (G_OUTPUT_STREAM (stream), "cat", 3, NULL, NULL,
+                             &error);
+  g_assert_no_error (error);
+
+  GVariant *report = gt_mock_file_get_memory_report (root, 1);
+  GVariantDict dict;
+  g_variant_dict_init (&dict, report);
+  guint64 value;
+  g_assert_true (g_variant_dict_lookup (&dict, "n-files", "t", &value));
+  g_assert_cmpuint (value, ==, 5);
+  g_assert_true (g_variant_dict_lookup (&dict, "logical-bytes", "t", &value));
+  g_assert_cmpuint (value, ==, 22);
+  g_assert_true (g_variant_dict_lookup (&dict, "resident-bytes", "t", &value));
+  g_assert_cmpuint (value, ==, 11);
+  g_assert_true (g_variant_dict_lookup (&dict, "n-open-streams", "t", &value));
+  g_assert_cmpuint (value, ==, 1);
+  g_assert_true (g_variant_dict_lookup (&dict, "buffered-bytes", "t", &value));
+  g_assert_cmpuint (value, ==, 3);
+  const char *path;
+  GVariant *subtrees = g_variant_dict_lookup_value (&dict, "largest-subtrees",
+                                                    G_VARIANT_TYPE ("a(st)"));
+  g_assert_cmpuint (g_variant_n_children (subtrees), ==, 1);
+  g_variant_get_child (subtrees, 0, "(&st)", &path, &value);
+  g_assert_cmpstr (path, ==, "/");
+  g_assert_cmpuint (value, ==, 22);
+  g_variant_unref (subtrees);
+  g_variant_dict_clear (&dict);
+  g_variant_unref (g_variant_ref_sink (report));
+
+  g_output_stream_close (G_OUTPUT_STREAM (stream), NULL, &error);
+  g_assert_no_error (error);
+  report = gt_mock_file_get_memory_report (root, 0);
+  g_variant_dict_init (&dict, report);
+  g_assert_true (g_variant_dict_lookup (&dict, "buffered-bytes", "t", &value));
+  g_assert_cmpuint (value, ==, 0);
+  g_variant_dict_clear (&dict);
+  g_variant_unref (g_variant_ref_sink (report));
+
+  g_object_unref (stream);
+  g_object_unref (a);
+  g_object_unref (b);
+  g_object_unref (c);
+  g_object_unref (root);
+}
+
+static void
+test_mock_bulk_populate_and_export (void)
+{
+  GtMockFile *root = gt_mock_file_new ();
+  GVariant *owl = g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, "owl", 3, 1);
+  GVariant *cat = g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, "cat", 3, 1);
+  GVariant *files = g_variant_new_parsed ("{'a': (true, %@ay), "
+                                          "'dir/b': (true, %@ay), "
+                                          "'dir/gone': (false, @ay [])}",
+                                          owl, cat);
+  gt_mock_file_populate (root, files);
+  g_variant_unref (g_variant_ref_sink (files));
+
+  GFile *b = g_file_resolve_relative_path (G_FILE (root), "dir/b");
+  g_assert_cmpstr (gt_mock_file_get_contents_utf8 (GT_MOCK_FILE (b)), ==, "cat");
+  g_object_unref (b);
+  GFile *gone = g_file_resolve_relative_path (G_FILE (root), "dir/gone");
+  g_assert_false (g_file_query_exists (gone, NULL));
+  g_object_unref (gone);
+
+  GHashTable *table = gt_mock_file_export_to_table (root);
+  /* "dir" exists, "dir/gone" doesn't */
+  g_assert_cmpuint (g_hash_table_size (table), ==, 3);
+  GBytes *contents = g_hash_table_lookup (table, "a");
+  g_assert_cmpmem (g_bytes_get_data (contents, NULL), g_bytes_get_size (contents),
+                   "owl", 3);
+  g_hash_table_unref (table);
+
+  GVariant *exported = gt_mock_file_export (root);
+  GtMockFile *copy = gt_mock_file_new ();
+  gt_mock_file_populate (copy, exported);
+  GFile *copy_b = g_file_resolve_relative_path (G_FILE (copy), "dir/b");
+  g_assert_cmpstr (gt_mock_file_get_contents_utf8 (GT_MOCK_FILE (copy_b)), ==,
+                   "cat");
+  g_object_unref (copy_b);
+
+  g_variant_unref (g_variant_ref_sink (exported));
+  g_object_unref (copy);
+  g_object_unref (root);
+}
+
+static void
+count_notify (GObject    *object,
+              GParamSpec *pspec,
+              int        *count)
+{
+  (*count)++;
+}
+
+static void
+test_mock_bulk_populate_notifies_exists (void)
+{
+  GtMockFile *root = gt_mock_file_new ();
+  GFile *a = g_file_get_child (G_FILE (root), "a");
+  int n_notified = 0;
+  g_signal_connect (a, "notify::exists", G_CALLBACK (count_notify),
+                    &n_notified);
+
+  GVariant *files = g_variant_new_parsed ("{'a': (false, @ay [])}");
+  gt_mock_file_populate (root, files);
+  g_variant_unref (g_variant_ref_sink (files));
+
+  g_assert_cmpint (n_notified, ==, 1);
+  g_assert_false (g_file_query_exists (a, NULL));
+
+  g_object_unref (a);
+  g_object_unref (root);
+}
+
+static void
+test_mock_bulk_populate_rejects_parent_paths (void)
+{
+  if (g_test_subprocess ())
+    {
+      GtMockFile *root = gt_mock_file_new ();
+      GVariant *files = g_variant_new_parsed ("{'dir/../../a': (true, @ay [])}");
+      gt_mock_file_populate (root, files);
+      g_variant_unref (g_variant_ref_sink (files));
+      g_object_unref (root);
+      return;
+    }
+  g_test_trap_subprocess (NULL, 0, 0);
+  g_test_trap_assert_failed ();
+  g_test_trap_assert_stderr ("*is_descendant_path*");
+}
+
+static void
+test_mock_bulk_export_skips_unnamed (void)
+{
+  GtMockFile *root = gt_mock_file_new ();
+  gt_mock_file_set_contents_utf8 (root, "owl");
+  GFile *parent = g_file_get_parent (G_FILE (root));
+  GFile *sibling = g_file_get_child (parent, "cat");
+  gt_mock_file_set_contents_utf8 (GT_MOCK_FILE (sibling), "cat");
+
+  /* The former root has no name, so only its named sibling is exported */
+  GHashTable *table = gt_mock_file_export_to_table (GT_MOCK_FILE (parent));
+  g_assert_cmpuint (g_hash_table_size (table), ==, 1);
+  g_assert_true (g_hash_table_contains (table, "cat"));
+  g_hash_table_unref (table);
+
+  GVariant *exported = gt_mock_file_export (GT_MOCK_FILE (parent));
+  g_assert_cmpuint (g_variant_n_children (exported), ==, 1);
+  g_variant_unref (g_variant_ref_sink (exported));
+
+  g_object_unref (sibling);
+  g_object_unref (parent);
+  g_object_unref (root);
+}
+
+static void
+test_mock_writev_is_one_write_call (void)
+{
+  GFile *file = G_FILE (gt_mock_file_new ());
+  GError *error = NULL;
+  GFileOutputStream *ostream = g_file_replace (file, NULL, FALSE,
+                                               G_FILE_CREATE_NONE, NULL, &error);
+  g_assert_no_error (error);
+
+  GOutputVector vectors[] = {
+    { "My big ", 7 },
+    { "sphinx ", 7 },
+    { "of quartz", 9 },
+  };
+  gsize bytes_written;
+  g_assert_true (g_output_stream_writev_all (G_OUTPUT_STREAM (ostream), vectors,
+                                             G_N_ELEMENTS (vectors), &bytes_written,
+                                             NULL, &error));
+  g_assert_no_error (error);
+  g_assert_cmpuint (bytes_written, ==, 23);
+  g_assert_cmpuint (gt_mock_file_get_n_write_calls (GT_MOCK_FILE (file)), ==, 1);
+
+  g_assert_true (g_output_stream_close (G_OUTPUT_STREAM (ostream), NULL, &error));
+  g_assert_no_error (error);
+  g_assert_cmpstr (gt_mock_file_get_contents_utf8 (GT_MOCK_FILE (file)), ==,
+                   SAMPLE_UTF8_CONTENTS);
+
+  g_object_unref (ostream);
+  g_object_unref (file);
+}
+
+static void
+test_mock_pipe_backpressure (void)
+{
+  GtMockPipe *first, *second;
+  gt_mock_pipe_new_pair (4, &first, &second);
+  g_assert_cmpuint (gt_mock_pipe_get_capacity (first), ==, 4);
+
+  GOutputStream *out = g_io_stream_get_output_stream (G_IO_STREAM (first));
+  GInputStream *in = g_io_stream_get_input_stream (G_IO_STREAM (second));
+  GError *error = NULL;
+  gssize count = g_pollable_output_stream_write_nonblocking (G_POLLABLE_OUTPUT_STREAM (out),
+                                                             "sphinx", 6, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (count, ==, 4);
+  g_assert_false (g_pollable_output_stream_is_writable (G_POLLABLE_OUTPUT_STREAM (out)));
+  count = g_pollable_output_stream_write_nonblocking (G_POLLABLE_OUTPUT_STREAM (out),
+                                                      "nx", 2, NULL, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK);
+  g_clear_error (&error);
+
+  char buffer[4];
+  g_assert_true (g_input_stream_read_all (in, buffer, 4, NULL, NULL, &error));
+  g_assert_no_error (error);
+  g_assert_cmpmem (buffer, 4, "sphi", 4);
+  g_assert_true (g_pollable_output_stream_is_writable (G_POLLABLE_OUTPUT_STREAM (out)));
+
+  /* The other end receives the same memory that was sent */
+  GBytes *sent = g_bytes_new_static ("quartz", 4);
+  gt_mock_pipe_send_bytes (first, sent, NULL, &error);
+  g_assert_no_error (error);
+  GBytes *received = gt_mock_pipe_receive_bytes (second, 16, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_true (g_bytes_get_data (received, NULL) == g_bytes_get_data (sent, NULL));
+  g_bytes_unref (received);
+  g_bytes_unref (sent);
+
+  g_assert_true (g_output_stream_close (out, NULL, &error));
+  g_assert_no_error (error);
+  received = gt_mock_pipe_receive_bytes (second, 16, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (g_bytes_get_size (received), ==, 0);
+  g_bytes_unref (received);
+
+  g_assert_true (g_input_stream_close (in, NULL, &error));
+  g_assert_no_error (error);
+
+  /* Sending and receiving respect the streams being closed */
+  sent = g_bytes_new_static ("owl", 3);
+  gt_mock_pipe_send_bytes (first, sent, NULL, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CLOSED);
+  g_clear_error (&error);
+  g_bytes_unref (sent);
+  received = gt_mock_pipe_receive_bytes (second, 16, NULL, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CLOSED);
+  g_assert_null (received);
+  g_clear_error (&error);
+
+  g_object_unref (first);
+  g_object_unref (second);
+}
+
+static void
+test_mock_pipe_loopback (void)
+{
+  GtMockPipe *pipe = g_object_new (GT_TYPE_MOCK_PIPE, "capacity", (gsize) 16,
+                                   NULL);
+  g_assert_cmpuint (gt_mock_pipe_get_capacity (pipe), ==, 16);
+
+  GError *error = NULL;
+  GBytes *sent = g_bytes_new_static ("owl", 3);
+  gt_mock_pipe_send_bytes (pipe, sent, NULL, &error);
+  g_assert_no_error (error);
+  GBytes *received = gt_mock_pipe_receive_bytes (pipe, 16, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_true (g_bytes_equal (received, sent));
+  g_bytes_unref (received);
+  g_bytes_unref (sent);
+
+  g_object_unref (pipe);
+}
+
+static void
+test_mock_read_bytes_is_zero_copy (Fixture      *fixture,
+                                   gconstpointer unused)
+{
+  GtMockFile *file = GT_MOCK_FILE (fixture->file);
+  gt_mock_file_set_contents_utf8 (file, SAMPLE_UTF8_CONTENTS);
+  GError *error = NULL;
+  GFileInputStream *stream = g_file_read (fixture->file, NULL, &error);
+  g_assert_no_error (error);
+  GtMockFileInputStream *mock_stream = GT_MOCK_FILE_INPUT_STREAM (stream);
+  GBytes *contents = gt_mock_file_get_contents (file);
+  const guint8 *data = g_bytes_get_data (contents, NULL);
+
+  gsize count;
+  const guint8 *peeked = gt_mock_file_input_stream_peek (mock_stream, &count);
+  g_assert_true (peeked == data);
+  g_assert_cmpuint (count, ==, strlen (SAMPLE_UTF8_CONTENTS));
+  g_assert_cmpuint (gt_mock_file_get_n_read_calls (file), ==, 0);
+
+  GBytes *slice = gt_mock_file_input_stream_read_bytes (mock_stream, 7, NULL,
+                                                        &error);
+  g_assert_no_error (error);
+  g_assert_true (g_bytes_get_data (slice, NULL) == data);
+  g_assert_cmpuint (g_bytes_get_size (slice), ==, 7);
+  g_bytes_unref (slice);
+  g_assert_cmpint (g_seekable_tell (G_SEEKABLE (stream)), ==, 7);
+
+  peeked = gt_mock_file_input_stream_peek (mock_stream, &count);
+  g_assert_true (peeked == data + 7);
+  g_assert_cmpuint (count, ==, strlen (SAMPLE_UTF8_CONTENTS) - 7);
+
+  slice = gt_mock_file_input_stream_read_bytes (mock_stream, 100, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (g_bytes_get_size (slice), ==, count);
+  g_bytes_unref (slice);
+  slice = gt_mock_file_input_stream_read_bytes (mock_stream, 100, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (g_bytes_get_size (slice), ==, 0);
+  g_bytes_unref (slice);
+
+  g_object_unref (stream);
+}
+
+static void
+test_mock_read_bytes_cancelled_keeps_chunk_cursor (Fixture      *fixture,
+                                                   gconstpointer unused)
+{
+  GtMockFile *file = GT_MOCK_FILE (fixture->file);
+  gt_mock_file_set_contents_utf8 (file, SAMPLE_UTF8_CONTENTS);
+  gsize sizes[] = { 3, 5 };
+  GtChunkPolicy *policy = gt_chunk_policy_new_sequence (sizes, 2);
+  gt_mock_file_set_read_chunk_policy (file, policy);
+  g_object_unref (policy);
+  GError *error = NULL;
+  GFileInputStream *stream = g_file_read (fixture->file, NULL, &error);
+  g_assert_no_error (error);
+  GtMockFileInputStream *mock_stream = GT_MOCK_FILE_INPUT_STREAM (stream);
+
+  GCancellable *cancellable = g_cancellable_new ();
+  g_cancellable_cancel (cancellable);
+  GBytes *slice = gt_mock_file_input_stream_read_bytes (mock_stream, 100,
+                                                        cancellable, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_assert_null (slice);
+  g_clear_error (&error);
+  g_object_unref (cancellable);
+
+  /* The cancelled read did not use up the first chunk size */
+  slice = gt_mock_file_input_stream_read_bytes (mock_stream, 100, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (g_bytes_get_size (slice), ==, 3);
+  g_bytes_unref (slice);
+  g_assert_cmpuint (gt_mock_file_get_n_read_calls (file), ==, 1);
+
+  g_object_unref (stream);
+}
+
+static void
+test_mock_skip_counts_as_read (Fixture      *fixture,
+                               gconstpointer unused)
+{
+  GtMockFile *file = GT_MOCK_FILE (fixture->file);
+  gt_mock_file_set_contents_utf8 (file, SAMPLE_UTF8_CONTENTS);
+  GtChunkPolicy *policy = gt_chunk_policy_new_fixed (2);
+  gt_mock_file_set_read_chunk_policy (file, policy);
+  g_object_unref (policy);
+  GError *error = NULL;
+  GFileInputStream *stream = g_file_read (fixture->file, NULL, &error);
+  g_assert_no_error (error);
+
+  gssize nskipped = g_input_stream_skip (G_INPUT_STREAM (stream), 5, NULL,
+                                         &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (nskipped, ==, 2);
+  g_assert_cmpint (g_seekable_tell (G_SEEKABLE (stream)), ==, 2);
+  g_assert_cmpuint (gt_mock_file_get_n_read_calls (file), ==, 1);
+  g_assert_cmpuint (gt_mock_file_get_n_bytes_read (file), ==, 2);
+
+  g_object_unref (stream);
+}
 
 int
 main (int    argc,
@@ -243,11 +1683,71 @@ main (int    argc,
   ADD_MOCK_FILE_TEST ("/mock/starts-empty", test_mock_starts_empty);
   ADD_MOCK_FILE_TEST ("/mock/stores-contents", test_mock_stores_contents);
   ADD_MOCK_FILE_TEST ("/mock/stores-contents-utf8", test_mock_stores_contents_utf8);
+  ADD_MOCK_FILE_TEST ("/mock/contents-utf8-is-borrowed",
+                      test_mock_contents_utf8_is_borrowed);
   ADD_MOCK_FILE_TEST ("/mock/reads-contents", test_mock_reads_contents);
+  ADD_MOCK_FILE_TEST ("/mock/read-bytes/zero-copy", test_mock_read_bytes_is_zero_copy);
+  ADD_MOCK_FILE_TEST ("/mock/read-bytes/cancelled-keeps-chunk-cursor",
+                      test_mock_read_bytes_cancelled_keeps_chunk_cursor);
+  ADD_MOCK_FILE_TEST ("/mock/skip-counts-as-read", test_mock_skip_counts_as_read);
+  ADD_MOCK_FILE_TEST ("/mock/fault/nth-call", test_mock_injects_fault_on_nth_call);
+  ADD_MOCK_FILE_TEST ("/mock/fault/path-pattern",
+                      test_mock_injects_fault_by_path_pattern);
+  ADD_MOCK_FILE_TEST ("/mock/fault/reproducible-random",
+                      test_mock_injects_reproducible_random_faults);
+  ADD_MOCK_FILE_TEST ("/mock/chunks/one-byte-reads",
+                      test_mock_reads_one_byte_at_a_time);
+  ADD_MOCK_FILE_TEST ("/mock/mount/filesystem-info",
+                      test_mock_mount_reports_filesystem_info);
+  ADD_MOCK_FILE_TEST ("/mock/etag/follows-contents", test_mock_etag_follows_contents);
+  ADD_MOCK_FILE_TEST ("/mock/etag/replace-conflict",
+                      test_mock_replace_detects_wrong_etag);
+  ADD_MOCK_FILE_TEST ("/mock/query-info/standard-attributes",
+                      test_mock_query_info_standard_attributes);
+  ADD_MOCK_FILE_TEST ("/mock/disk-usage/subtree",
+                      test_mock_measures_disk_usage_of_subtree);
+  ADD_MOCK_FILE_TEST ("/mock/assert/contents", test_mock_content_assertions);
+  ADD_MOCK_FILE_TEST ("/mock/write-mode/no-store",
+                      test_mock_write_modes_do_not_store);
+  ADD_MOCK_FILE_TEST ("/mock/pollable/read-waits-for-writer",
+                      test_mock_pollable_read_waits_for_writer);
+  ADD_MOCK_FILE_TEST ("/mock/storage/memfd", test_mock_memfd_storage_exposes_fd);
 
 #undef ADD_MOCK_FILE_TEST
 
   g_test_add_func ("/mock/writes-contents", test_mock_writes_contents);
+  g_test_add_func ("/mock/chunks/write-sequence", test_mock_writes_in_chunk_sequence);
+  g_test_add_func ("/mock/mount/fills-up", test_mock_mount_fills_up_at_exact_byte);
+  g_test_add_func ("/mock/mount/failed-close-releases-space",
+                   test_mock_mount_failed_close_releases_space);
+  g_test_add_func ("/mock/io-counters/concurrent-reads",
+                   test_mock_counts_concurrent_reads);
+  g_test_add_func ("/mock/mount/concurrent-writers",
+                   test_mock_mount_concurrent_writers_share_space);
+  g_test_add_func ("/mock/assert/fails-on-mismatch",
+                   test_mock_content_assertion_fails_on_mismatch);
+  g_test_add_func ("/mock/arena/shares-files", test_mock_arena_shares_files);
+  g_test_add_func ("/mock/arena/reclaims-space", test_mock_arena_reclaims_space);
+  g_test_add_func ("/mock/arena/rejects-bad-layout",
+                   test_mock_arena_rejects_bad_layout);
+  g_test_add_func ("/mock/dump/round-trip", test_mock_dump_round_trip);
+  g_test_add_func ("/mock/dump/rejects-bad-names",
+                   test_mock_dump_rejects_bad_names);
+  g_test_add_func ("/mock/filesystem/frees-tree", test_mock_filesystem_frees_tree);
+  g_test_add_func ("/mock/filesystem/clear-resets-usage",
+                   test_mock_filesystem_clear_resets_usage);
+  g_test_add_func ("/mock/memory-report", test_mock_memory_report);
+  g_test_add_func ("/mock/bulk/populate-and-export",
+                   test_mock_bulk_populate_and_export);
+  g_test_add_func ("/mock/bulk/populate-notifies-exists",
+                   test_mock_bulk_populate_notifies_exists);
+  g_test_add_func ("/mock/bulk/populate-rejects-parent-paths",
+                   test_mock_bulk_populate_rejects_parent_paths);
+  g_test_add_func ("/mock/bulk/export-skips-unnamed",
+                   test_mock_bulk_export_skips_unnamed);
+  g_test_add_func ("/mock/writev/one-write-call", test_mock_writev_is_one_write_call);
+  g_test_add_func ("/mock/pipe/backpressure", test_mock_pipe_backpressure);
+  g_test_add_func ("/mock/pipe/loopback", test_mock_pipe_loopback);
 
   return g_test_run ();
 }
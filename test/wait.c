@@ -362,6 +362,238 @@ test_wait_cancellable_async_fail (Fixture      *fixture,
   g_assert_cmpuint (fixture->changer->count, ==, 0);
 }
 
+static void
+test_wait_condition_timed (Fixture      *fixture,
+                           gconstpointer unused)
+{
+  GtWaitStats stats;
+  gt_changer_start (fixture->changer);
+  g_assert_true (gt_wait_for_condition_timed (5000000, G_OBJECT (fixture->changer),
+                                              "notify::count",
+                                              (GtPredicate) count_is_2,
+                                              fixture->changer, NULL, NULL,
+                                              NULL, &stats));
+  g_assert_cmpuint (stats.n_emissions, ==, 2);
+  g_assert_cmpuint (stats.n_iterations, >=, 2);
+  /* At least the first change happened during the wait; only a generous
+  lower bound, since the changer started ticking before the wait did */
+  g_assert_cmpint (stats.elapsed, >=, 100000);
+}
+
+static void
+test_wait_async_within_budget (Fixture      *fixture,
+                               gconstpointer unused)
+{
+  g_assert_true (gt_assert_async_within (150000,
+                                         (GtAsyncBegin) start_changer_async,
+                                         fixture->changer,
+                                         (GtAsyncFinish) finish_changer_async,
+                                         fixture));
+  g_assert_cmpuint (fixture->changer->count, ==, 1);
+}
+
+static void
+test_wait_async_over_budget (void)
+{
+  if (g_test_subprocess ())
+    {
+      GtChanger *changer = g_object_new (gt_changer_get_type (), NULL);
+      gt_assert_cancellable_async_within (1000,
+                                          (GtCancellableAsyncBegin) start_changer_cancellable_async,
+                                          changer, NULL, NULL);
+      g_object_unref (changer);
+      return;
+    }
+  g_test_trap_subprocess (NULL, 0, 0);
+  g_test_trap_assert_failed ();
+  g_test_trap_assert_stdout ("*did not complete within 1000*");
+}
+
+static gboolean
+return_later (GTask *task)
+{
+  g_task_return_boolean (task, TRUE);
+  g_object_unref (task);
+  return G_SOURCE_REMOVE;
+}
+
+/* Operation number @index takes (index + 1) * 20 ms, in the thread-default
+context like real async operations */
+static void
+start_staggered_async (unsigned            index,
+                       GAsyncReadyCallback callback,
+                       gpointer            callback_data)
+{
+  GTask *task = g_task_new (NULL, NULL, callback, callback_data);
+  GSource *source = g_timeout_source_new ((index + 1) * 20);
+  g_source_set_callback (source, (GSourceFunc) return_later, task, NULL);
+  g_source_attach (source, g_main_context_get_thread_default ());
+  g_source_unref (source);
+}
+
+static void
+count_finished (unsigned      index,
+                GAsyncResult *result,
+                unsigned     *n_finished)
+{
+  g_assert_true (g_task_propagate_boolean (G_TASK (result), NULL));
+  (*n_finished)++;
+}
+
+static void
+test_wait_many_async_all (void)
+{
+  unsigned n_finished = 0;
+  gint64 *times;
+  int n_times;
+  GtWaitStats stats;
+  g_assert_true (gt_wait_for_many_async (10000000, 5,
+                                         (GtIndexedAsyncBegin) start_staggered_async,
+                                         NULL,
+                                         (GtIndexedAsyncFinish) count_finished,
+                                         &n_finished, GT_WAIT_FOR_MANY_ALL,
+                                         &times, &n_times, &stats));
+  g_assert_cmpuint (n_finished, ==, 5);
+  g_assert_cmpint (n_times, ==, 5);
+  for (int ix = 1; ix < n_times; ix++)
+    g_assert_cmpint (times[ix], >, times[ix - 1]);
+  /* The wait lasted until the last operation completed */
+  g_assert_cmpint (stats.elapsed, >=, times[n_times - 1]);
+  g_free (times);
+}
+
+static void
+test_wait_many_async_first (void)
+{
+  unsigned n_finished = 0;
+  gint64 *times;
+  int n_times;
+  g_assert_true (gt_wait_for_many_async (1000000, 3,
+                                         (GtIndexedAsyncBegin) start_staggered_async,
+                                         NULL,
+                                         (GtIndexedAsyncFinish) count_finished,
+                                         &n_finished, GT_WAIT_FOR_MANY_FIRST,
+                                         &times, &n_times, NULL));
+  g_assert_cmpuint (n_finished, ==, 1);
+  g_assert_cmpint (times[0], >=, 0);
+  g_assert_cmpint (times[1], ==, -1);
+  g_assert_cmpint (times[2], ==, -1);
+  g_free (times);
+
+  /* The others complete later without anything going wrong */
+  GMainLoop *loop = g_main_loop_new (NULL, FALSE);
+  g_timeout_add (100, (GSourceFunc) g_main_loop_quit, loop);
+  g_main_loop_run (loop);
+  g_main_loop_unref (loop);
+  g_assert_cmpuint (n_finished, ==, 1);
+}
+
+static gpointer
+wait_in_thread (gpointer unused)
+{
+  /* Each thread's async operation completes in that thread's own context */
+  unsigned n_finished = 0;
+  gint64 *times;
+  int n_times;
+  g_assert_true (gt_wait_for_many_async (1000000, 2,
+                                         (GtIndexedAsyncBegin) start_staggered_async,
+                                         NULL,
+                                         (GtIndexedAsyncFinish) count_finished,
+                                         &n_finished, GT_WAIT_FOR_MANY_ALL,
+                                         &times, &n_times, NULL));
+  g_free (times);
+  g_assert_null (g_main_context_get_thread_default ());
+  return GUINT_TO_POINTER (n_finished);
+}
+
+static void
+test_wait_in_threads (void)
+{
+  GThread *threads[4];
+  for (int ix = 0; ix < 4; ix++)
+    threads[ix] = g_thread_new ("waiter", wait_in_thread, NULL);
+  for (int ix = 0; ix < 4; ix++)
+    g_assert_cmpuint (GPOINTER_TO_UINT (g_thread_join (threads[ix])), ==, 2);
+}
+
+typedef struct
+{
+  GFile *file;
+  guint64 disk_usage;
+} Measurement;
+
+static void
+start_measuring_disk_usage (GAsyncReadyCallback callback,
+                            gpointer            callback_data,
+                            Measurement        *measurement)
+{
+  g_file_measure_disk_usage_async (measurement->file, G_FILE_MEASURE_APPARENT_SIZE,
+                                   G_PRIORITY_DEFAULT, NULL, NULL, NULL,
+                                   callback, callback_data);
+}
+
+static void
+finish_measuring_disk_usage (GAsyncResult *result,
+                             Measurement  *measurement)
+{
+  GError *error = NULL;
+  g_assert_true (g_file_measure_disk_usage_finish (measurement->file, result,
+                                                   &measurement->disk_usage,
+                                                   NULL, NULL, &error));
+  g_assert_no_error (error);
+}
+
+static gpointer
+measure_in_thread (GFile *file)
+{
+  Measurement measurement = { file, 0 };
+  gboolean completed = gt_wait_for_async (1000,
+                                          (GtAsyncBegin) start_measuring_disk_usage,
+                                          &measurement,
+                                          (GtAsyncFinish) finish_measuring_disk_usage,
+                                          &measurement);
+  return GUINT_TO_POINTER (completed && measurement.disk_usage == 3);
+}
+
+static void
+test_wait_mock_file_io_in_thread (void)
+{
+  GtMockFile *file = gt_mock_file_new ();
+  gt_mock_file_set_contents_utf8 (file, "owl");
+  /* The worker thread can't run the global default context while this thread
+  owns it, so it waits in a new context of its own, where the mock file must
+  report its result */
+  g_assert_true (g_main_context_acquire (NULL));
+  GThread *thread = g_thread_new ("waiter", (GThreadFunc) measure_in_thread, file);
+  g_assert_true (GPOINTER_TO_UINT (g_thread_join (thread)));
+  g_main_context_release (NULL);
+  g_object_unref (file);
+}
+
+static gboolean
+set_flag (gboolean *flag)
+{
+  *flag = TRUE;
+  return G_SOURCE_REMOVE;
+}
+
+static void
+test_wait_thread_leaves_main_context_alone (void)
+{
+  GtMockFile *file = gt_mock_file_new ();
+  gt_mock_file_set_contents_utf8 (file, "owl");
+  /* Nothing runs the global default context while the worker waits, but the
+  worker must still not dispatch this thread's sources */
+  gboolean dispatched = FALSE;
+  guint id = g_idle_add ((GSourceFunc) set_flag, &dispatched);
+  GThread *thread = g_thread_new ("waiter", (GThreadFunc) measure_in_thread, file);
+  g_assert_true (GPOINTER_TO_UINT (g_thread_join (thread)));
+  g_assert_false (dispatched);
+
+  g_source_remove (id);
+  g_object_unref (file);
+}
+
 int
 main (int    argc,
       char **argv)
@@ -382,7 +614,18 @@ main (int    argc,
   ADD_WAIT_TEST ("/wait/async/cancellable-normal", test_wait_cancellable_async_normal);
   ADD_WAIT_TEST ("/wait/async/cancellable-fail", test_wait_cancellable_async_fail);
 
+  ADD_WAIT_TEST ("/wait/condition/timed", test_wait_condition_timed);
+  ADD_WAIT_TEST ("/wait/async/within-budget", test_wait_async_within_budget);
+
 #undef ADD_WAIT_TEST
 
+  g_test_add_func ("/wait/async/over-budget", test_wait_async_over_budget);
+  g_test_add_func ("/wait/many-async/all", test_wait_many_async_all);
+  g_test_add_func ("/wait/many-async/first", test_wait_many_async_first);
+  g_test_add_func ("/wait/threads", test_wait_in_threads);
+  g_test_add_func ("/wait/threads/mock-file-io", test_wait_mock_file_io_in_thread);
+  g_test_add_func ("/wait/threads/main-context-untouched",
+                   test_wait_thread_leaves_main_context_alone);
+
   return g_test_run ();
 }